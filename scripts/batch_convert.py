@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+"""
+Batch conversion with a content-hash cache, shared by both converters.
+
+Given directories or several files, every source file is converted into the
+same layout under an output directory by a pool of worker processes. With a
+cache directory, each result is stored under the SHA-256 of the file, the
+converter's own source and its options, so an unchanged file is copied from
+the cache instead of being parsed again. Outputs are only rewritten when
+their content changes, which keeps their mtime stable for make.
+
+Each converter supplies a picklable job(input_path, output_path) returning
+(constructs converted, warnings, failed); see convert_job() in
+cilk_to_openmp.py and cilk_to_openmp_treesitter.py.
+"""
+
+import os
+import json
+import hashlib
+from pathlib import Path
+from concurrent.futures import ProcessPoolExecutor
+
+SOURCE_SUFFIXES = ('.c', '.h')
+
+
+def write_if_changed(path, data):
+    """Write data to path unless it already holds exactly that; returns True if written."""
+    path = Path(path)
+    try:
+        if path.read_bytes() == data:
+            return False
+    except OSError:
+        pass
+    path.parent.mkdir(parents=True, exist_ok=True)
+    path.write_bytes(data)
+    return True
+
+
+class BatchConverter:
+    def __init__(self, job, converter_path, options, jobs=None, cache_dir=None,
+                 suffixes=SOURCE_SUFFIXES):
+        self.job = job
+        # Any change to the converter or this module invalidates the cache
+        digest = hashlib.sha256()
+        digest.update(Path(converter_path).read_bytes())
+        digest.update(Path(__file__).read_bytes())
+        digest.update(json.dumps(options, sort_keys=True).encode())
+        self.salt = digest.digest()
+        self.jobs = jobs or os.cpu_count() or 1
+        self.cache_dir = Path(cache_dir) if cache_dir else None
+        self.suffixes = suffixes
+        self.warnings = []
+        self.failed = []
+        self.files = 0
+        self.cached = 0
+        self.conversions = 0
+
+    def collect(self, inputs, output_dir):
+        """(source, destination) pairs: directory trees keep their layout, files go to the top."""
+        output_dir = Path(output_dir).resolve()
+        pairs = []
+        for path in map(Path, inputs):
+            if not path.is_dir():
+                pairs.append((path, output_dir / path.name))
+                continue
+            for src in sorted(path.rglob('*')):
+                if src.suffix in self.suffixes and src.is_file() and \
+                        output_dir not in src.resolve().parents:
+                    pairs.append((src, output_dir / src.relative_to(path)))
+        return pairs
+
+    def cache_key(self, source_bytes):
+        return hashlib.sha256(self.salt + source_bytes).hexdigest()
+
+    def cache_paths(self, key):
+        entry = self.cache_dir / key[:2] / key
+        return entry.with_suffix('.out'), entry.with_suffix('.json')
+
+    def lookup(self, key):
+        """Cached (output bytes, (count, warnings, failed)) for key, or None."""
+        if not self.cache_dir:
+            return None
+        output, meta = self.cache_paths(key)
+        try:
+            result = json.loads(meta.read_text())
+            return output.read_bytes(), (result['count'], result['warnings'], result['failed'])
+        except (OSError, ValueError, KeyError):
+            return None
+
+    def store(self, key, output_bytes, result):
+        if not self.cache_dir:
+            return
+        output, meta = self.cache_paths(key)
+        output.parent.mkdir(parents=True, exist_ok=True)
+        output.write_bytes(output_bytes)
+        count, warnings, failed = result
+        # Metadata last: an entry without it is a miss
+        meta.write_text(json.dumps({'count': count, 'warnings': warnings, 'failed': failed}))
+
+    def record(self, src, result):
+        count, warnings, failed = result
+        self.files += 1
+        self.conversions += count
+        self.warnings += [f'{src}: {w}' for w in warnings]
+        if failed:
+            self.failed.append(str(src))
+
+    def run(self, inputs, output_dir):
+        pending = []
+        for src, dst in self.collect(inputs, output_dir):
+            key = self.cache_key(src.read_bytes())
+            hit = self.lookup(key)
+            if hit:
+                output_bytes, result = hit
+                write_if_changed(dst, output_bytes)
+                self.cached += 1
+                self.record(src, result)
+            else:
+                dst.parent.mkdir(parents=True, exist_ok=True)
+                pending.append((src, dst, key))
+
+        if len(pending) > 1 and self.jobs > 1:
+            with ProcessPoolExecutor(max_workers=min(self.jobs, len(pending))) as pool:
+                futures = [pool.submit(self.job, str(src), str(dst)) for src, dst, _ in pending]
+                outcomes = [self.outcome(f.result) for f in futures]
+        else:
+            outcomes = [self.outcome(lambda: self.job(str(src), str(dst))) for src, dst, _ in pending]
+
+        for (src, dst, key), (result, error) in zip(pending, outcomes):
+            if error:
+                self.files += 1
+                self.failed.append(str(src))
+                self.warnings.append(f'{src}: ERROR: conversion failed: {error}')
+                continue
+            self.store(key, dst.read_bytes(), result)
+            self.record(src, result)
+        return self
+
+    @staticmethod
+    def outcome(call):
+        """(result, None) from call(), or (None, error message) if it raised."""
+        try:
+            return call(), None
+        except Exception as e:  # one broken file must not stop the batch
+            return None, f'{type(e).__name__}: {e}'
+
+    def write_log(self, log_file):
+        if log_file:
+            with open(log_file, 'w') as f:
+                for w in self.warnings:
+                    f.write(w + '\n')
+                if not self.warnings:
+                    f.write('No warnings\n')
+
+    def summary(self):
+        return (f"Converted {self.conversions} Cilk Plus constructs in {self.files} files "
+                f"({self.cached} from cache)")
@@ -1,13 +1,27 @@
 #!/bin/bash
-# Benchmark Cilk Plus vs OpenMP SIMD performance
+# Benchmark Cilk Plus vs OpenMP SIMD kernels in a single process
+#
+# Builds bench_runner with the Cilk Plus variant from CILK_CC (GCC 7) and the
+# OpenMP SIMD variant from OMP_CC, then times both against the same buffers.
+# Without CILK_CC only the OpenMP variant is benchmarked.
+#
+# Usage: scripts/benchmark.sh [--format csv|json] [N ...]
 
-ITERATIONS=${1:-100}
+set -e
 
-echo "=== Performance Comparison ($ITERATIONS iterations) ==="
+CILK_CC=${CILK_CC:-gcc-7}
+OMP_CC=${OMP_CC:-gcc}
+CFLAGS=${CFLAGS:--O2}
 
-echo "Cilk Plus (GCC 7):"
-time for i in $(seq 1 $ITERATIONS); do ./cilk_test > /dev/null; done
+$OMP_CC -fopenmp-simd $CFLAGS -c -o kernels_openmp.o src/kernels_openmp.c
 
-echo ""
-echo "OpenMP SIMD (GCC 11):"
-time for i in $(seq 1 $ITERATIONS); do ./openmp_test > /dev/null; done
+if command -v "$CILK_CC" > /dev/null; then
+    $CILK_CC -fcilkplus $CFLAGS -DHAVE_CILK -o bench_runner \
+        src/bench_runner.c src/kernels_cilk.c kernels_openmp.o -lm
+else
+    echo "$CILK_CC not found, benchmarking OpenMP SIMD only" >&2
+    $OMP_CC -fopenmp-simd $CFLAGS -o bench_runner \
+        src/bench_runner.c kernels_openmp.o -lm
+fi
+
+./bench_runner "$@"
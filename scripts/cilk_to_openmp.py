@@ -4,28 +4,60 @@ Convert Cilk Plus array notation to OpenMP SIMD.
 
 Patterns handled:
 1. array[0:N] = expr(other[0:N]) -> #pragma omp simd + loop
-2. __sec_reduce_add(array[0:N]) -> #pragma omp simd reduction + loop
-3. Handles vALL macro (0:VLENGTH) used in MCsquare
+2. __sec_reduce_add/mul/max/min/any_nonzero/all_zero(array[0:N]) ->
+   #pragma omp simd reduction + loop; max_ind/min_ind -> value then index loop
+3. Handles vALL macro (0:VLENGTH) used in MCsquare, and offset/strided
+   sections array[s:N:k] -> array[s + i*k]
+4. cilk_for -> #pragma omp parallel for schedule(dynamic|guided), with
+   '#pragma cilk grainsize' as the chunk size
+5. cilk_spawn -> #pragma omp task, cilk_sync -> #pragma omp taskwait
+
+Several files or a directory convert in batch mode into an output
+directory, in parallel worker processes, with an optional content-hash
+cache (see batch_convert.py).
 
 Usage:
-    python cilk_to_openmp.py input.c output.c [--log errors.log]
+    python cilk_to_openmp.py input.c output.c [--log errors.log] [--cilk-for-schedule dynamic|guided]
+    python cilk_to_openmp.py src/ converted/ [--jobs N] [--cache DIR]
 """
 
 import re
 import sys
 import argparse
+from functools import partial
 from pathlib import Path
 
+from batch_convert import BatchConverter, write_if_changed
+
+
+# __sec_reduce_<op>: (omp reduction identifier, initial value, loop body);
+# max and min start from the first element
+SEC_REDUCTIONS = {
+    'add': ('+', '0', '{var} += {elem};'),
+    'mul': ('*', '1', '{var} *= {elem};'),
+    'max': ('max', '{first}', '{var} = {elem} > {var} ? {elem} : {var};'),
+    'min': ('min', '{first}', '{var} = {elem} < {var} ? {elem} : {var};'),
+    'any_nonzero': ('||', '0', '{var} = {var} || {elem} != 0;'),
+    'any_zero': ('||', '0', '{var} = {var} || {elem} == 0;'),
+    'all_nonzero': ('&&', '1', '{var} = {var} && {elem} != 0;'),
+    'all_zero': ('&&', '1', '{var} = {var} && {elem} == 0;'),
+}
+
+# __sec_reduce_max_ind/min_ind: reduce the value and a NaN flag, then the lowest
+# index holding the value (or the first NaN)
+SEC_INDEX_REDUCTIONS = {'max_ind': 'max', 'min_ind': 'min'}
+
 
 class CilkConverter:
-    def __init__(self, log_file=None):
+    def __init__(self, log_file=None, cilk_for_schedule='dynamic'):
         self.log_file = log_file
         self.warnings = []
         self.conversions = 0
+        self.cilk_for_schedule = cilk_for_schedule
 
-        # Pattern for array slice notation: name[start:length] or name[vALL]
-        # Captures: array_name, slice_content (e.g., "0:VLENGTH" or "vALL")
-        self.slice_pattern = r'(\w+)\[((?:\d+:\w+)|(?:vALL))\]'
+        # Pattern for array slice notation: name[start:length[:stride]] or name[vALL]
+        # Captures: array_name, slice_content (e.g., "0:VLENGTH", "1:n:3" or "vALL")
+        self.slice_pattern = r'(\w+)\[((?:[^\[\]:;?]+:[^\[\]:;?]+(?::[^\[\]:;?]+)?)|(?:vALL))\]'
 
     def log(self, msg):
         self.warnings.append(msg)
@@ -45,9 +77,19 @@ class CilkConverter:
             return 'VLENGTH'  # MCsquare convention
         if ':' in slice_content:
             parts = slice_content.split(':')
-            return parts[1]  # The length part
+            return parts[1].strip()  # The length part
         return None
 
+    def slice_index(self, slice_content):
+        """Element index of a slice at loop index i: start + i*stride."""
+        if slice_content == 'vALL':
+            return 'i'
+        parts = [p.strip() for p in slice_content.split(':')]
+        start, stride = parts[0], parts[2] if len(parts) > 2 else '1'
+        paren = lambda e: e if re.fullmatch(r'\w+', e) else f'({e})'
+        step = 'i' if stride == '1' else f'i * {paren(stride)}'
+        return step if start == '0' else f'{paren(start)} + {step}'
+
     def convert_array_assignment(self, line, indent):
         """
         Convert: array[0:N] = expr(other[0:N])
@@ -72,14 +114,9 @@ class CilkConverter:
             self.log(f"WARNING: Could not extract length from: {line.strip()}")
             return None
 
-        # Replace all array[slice] with array[i]
-        converted = line
-        for array_name, slice_content in slices:
-            converted = re.sub(
-                rf'\b{re.escape(array_name)}\[{re.escape(slice_content)}\]',
-                f'{array_name}[i]',
-                converted
-            )
+        # Replace all array[slice] with array[start + i*stride]
+        converted = re.sub(self.slice_pattern,
+                           lambda m: f'{m.group(1)}[{self.slice_index(m.group(2))}]', line)
 
         # Build the replacement
         result = [
@@ -94,17 +131,19 @@ class CilkConverter:
 
     def convert_reduction(self, line, indent):
         """
-        Convert: type result = __sec_reduce_add(array[0:N])
-        To: type result = 0;
-            #pragma omp simd reduction(+:result)
+        Convert: type result = __sec_reduce_<op>(array[0:N])
+        To: type result = <identity>;
+            #pragma omp simd reduction(<op>:result)
             for (int i = 0; i < N; i++) {
-                result += array[i];
+                result = result <op> array[i];
             }
+        The _ind variants become a value reduction followed by an index reduction.
         """
-        # Match: [type] var = __sec_reduce_add(array[slice])
+        # Match: [type] var = __sec_reduce_<op>(array[slice])
         # Type is optional (variable may already be declared)
         match = re.match(
-            r'(\s*)((?:int|double|float)\s+)?(\w+)\s*=\s*__sec_reduce_add\((\w+)\[((?:\d+:\w+)|(?:vALL))\]\)\s*;',
+            r'(\s*)((?:(?:unsigned|long|int|double|float)\s+)+)?(\w+)\s*=\s*__sec_reduce_(\w+)'
+            r'\(' + self.slice_pattern + r'\)\s*;',
             line
         )
         if not match:
@@ -112,47 +151,146 @@ class CilkConverter:
 
         type_decl = match.group(2) or ''  # May be empty if var already declared
         result_var = match.group(3)
-        array_name = match.group(4)
-        slice_content = match.group(5)
+        op_name = match.group(4)
+        array_name = match.group(5)
+        slice_content = match.group(6)
+
+        if op_name not in SEC_REDUCTIONS and op_name not in SEC_INDEX_REDUCTIONS:
+            self.log(f"WARNING: Unsupported reduction __sec_reduce_{op_name}: {line.strip()}")
+            return None
 
         length_var = self.extract_length_var(slice_content)
         if not length_var:
             self.log(f"WARNING: Could not extract length from reduction: {line.strip()}")
             return None
 
+        elem = f'{array_name}[{self.slice_index(slice_content)}]'
+        first = f'{array_name}[0]' if slice_content == 'vALL' else f'{array_name}[{slice_content.split(":")[0].strip()}]'
+
         # Build the replacement
-        result = [
-            f'{indent}{type_decl}{result_var} = 0;',
-            f'{indent}#pragma omp simd reduction(+:{result_var})',
-            f'{indent}for (int i = 0; i < {length_var}; i++) {{',
-            f'{indent}    {result_var} += {array_name}[i];',
-            f'{indent}}}'
-        ]
+        if op_name in SEC_INDEX_REDUCTIONS:
+            op = SEC_INDEX_REDUCTIONS[op_name]
+            value_var = f'{result_var}_value'
+            nan_var = f'{result_var}_nan'
+            _, _, body = SEC_REDUCTIONS[op]
+            result = [
+                f'{indent}__typeof__({first} + 0) {value_var} = {first};',
+                f'{indent}int {nan_var} = 0;',
+                f'{indent}#pragma omp simd reduction({op}:{value_var}) reduction(||:{nan_var})',
+                f'{indent}for (int i = 0; i < {length_var}; i++) {{',
+                f'{indent}    {body.format(var=value_var, elem=elem)}',
+                f'{indent}    {nan_var} = {nan_var} || {elem} != {elem};',
+                f'{indent}}}',
+                f'{indent}{type_decl}{result_var} = {length_var};',
+                f'{indent}#pragma omp simd reduction(min:{result_var})',
+                f'{indent}for (int i = 0; i < {length_var}; i++) {{',
+                # Vector max/min drop NaN operands, so with a NaN flagged the first NaN is taken
+                f'{indent}    if (({nan_var} ? {elem} != {elem} : {elem} == {value_var}) && i < {result_var}) '
+                f'{result_var} = i;',
+                f'{indent}}}'
+            ]
+        else:
+            op, init, body = SEC_REDUCTIONS[op_name]
+            result = [
+                f'{indent}{type_decl}{result_var} = {init.format(first=first)};',
+                f'{indent}#pragma omp simd reduction({op}:{result_var})',
+                f'{indent}for (int i = 0; i < {length_var}; i++) {{',
+                f'{indent}    {body.format(var=result_var, elem=elem)}',
+                f'{indent}}}'
+            ]
 
         self.conversions += 1
         return '\n'.join(result)
 
+    def convert_cilk_for(self, line, indent, grainsize):
+        """
+        Convert: cilk_for (int i = 0; i < N; i++)
+        To: #pragma omp parallel for schedule(dynamic)
+            for (int i = 0; i < N; i++)
+        """
+        schedule = self.cilk_for_schedule
+        if grainsize:
+            schedule += f', {grainsize}'
+        self.conversions += 1
+        return (f'{indent}#pragma omp parallel for schedule({schedule})\n'
+                + re.sub(r'\b(?:_Cilk_for|cilk_for)\b', 'for', line, count=1))
+
+    def convert_spawn(self, line, indent, line_no):
+        """
+        Convert: [type] x = cilk_spawn f(args);
+        To: [type x;]
+            #pragma omp task shared(x)
+            x = f(args);
+        """
+        stmt = re.sub(r'\b(?:_Cilk_spawn|cilk_spawn)\s*', '', line.strip())
+        result = []
+        decl = re.match(r'((?:[\w*]+\s+)+\**)(\w+)\s*=\s*(.+;)$', stmt)
+        if decl and not re.match(r'\w+\s*=', stmt):
+            result.append(f'{indent}{decl.group(1).rstrip()} {decl.group(2)};')
+            stmt = f'{decl.group(2)} = {decl.group(3)}'
+        assign = re.match(r'(\w+)\s*(?:\[[^\]]*\]|\.\w+|->\w+)*\s*[-+*/]?=(?!=)', stmt)
+        result.append(f'{indent}#pragma omp task shared({assign.group(1)})' if assign
+                      else f'{indent}#pragma omp task')
+        result.append(f'{indent}{stmt}')
+
+        self.log(f"WARNING: line {line_no}: cilk_spawn converted to omp task; add '#pragma omp taskwait' "
+                 f"before the function returns (Cilk's implicit sync is not converted)")
+        self.conversions += 1
+        return '\n'.join(result)
+
     def convert_file(self, input_path, output_path):
         """Convert a single file."""
         with open(input_path, 'r') as f:
             lines = f.readlines()
 
         output_lines = []
+        grainsize = None
         i = 0
 
         while i < len(lines):
             line = lines[i]
             indent = re.match(r'^(\s*)', line).group(1)
+            stripped = line.strip()
+
+            # Grainsize applies to the next cilk_for
+            match = re.match(r'#\s*pragma\s+cilk\s+grainsize\s*(?:=\s*(.+?)|\((.+)\))\s*$', stripped)
+            if match:
+                grainsize = (match.group(1) or match.group(2)).strip()
+                i += 1
+                continue
 
             # Skip preprocessor directives and comments
-            stripped = line.strip()
             if stripped.startswith('#') or stripped.startswith('//') or stripped.startswith('/*'):
                 output_lines.append(line)
                 i += 1
                 continue
 
+            # Task parallelism keywords
+            if re.match(r'(?:_Cilk_for|cilk_for)\b', stripped):
+                output_lines.append(self.convert_cilk_for(line, indent, grainsize))
+                grainsize = None
+                i += 1
+                continue
+            if re.search(r'\b(?:_Cilk_spawn|cilk_spawn)\b', line):
+                output_lines.append(self.convert_spawn(line, indent, i + 1) + '\n')
+                i += 1
+                continue
+            if re.fullmatch(r'(?:_Cilk_sync|cilk_sync)\s*;', stripped):
+                output_lines.append(f'{indent}#pragma omp taskwait\n')
+                self.conversions += 1
+                i += 1
+                continue
+
+            # Masked conditionals span several lines; only the tree-sitter converter handles them
+            if re.match(r'(?:\}\s*else\s+)?if\s*\(', stripped) and re.search(self.slice_pattern, line):
+                self.log(f"WARNING: Line {i + 1}: conditional with array notation not converted; "
+                         f"use cilk_to_openmp_treesitter.py [--if-convert]")
+                output_lines.append(line)
+                i += 1
+                continue
+
             # Try reduction conversion first (more specific pattern)
-            if '__sec_reduce_add' in line:
+            if '__sec_reduce_' in line:
                 converted = self.convert_reduction(line, indent)
                 if converted:
                     output_lines.append(converted + '\n')
@@ -160,7 +298,7 @@ class CilkConverter:
                     continue
 
             # Try array assignment conversion (but not reductions)
-            if re.search(self.slice_pattern, line) and '=' in line and '__sec_reduce_add' not in line and not line.strip().startswith('//'):
+            if re.search(self.slice_pattern, line) and '=' in line and '__sec_reduce_' not in line and not line.strip().startswith('//'):
                 converted = self.convert_array_assignment(line, indent)
                 if converted:
                     output_lines.append(converted + '\n')
@@ -171,22 +309,48 @@ class CilkConverter:
             output_lines.append(line)
             i += 1
 
-        with open(output_path, 'w') as f:
-            f.writelines(output_lines)
+        write_if_changed(output_path, ''.join(output_lines).encode())
 
         return self.conversions
 
 
+def convert_job(options, input_path, output_path):
+    """Convert one file in batch mode; returns (constructs, warnings, failed)."""
+    converter = CilkConverter(**options)
+    count = converter.convert_file(input_path, output_path)
+    return count, converter.warnings, False
+
+
 def main():
     parser = argparse.ArgumentParser(description='Convert Cilk Plus to OpenMP SIMD')
-    parser.add_argument('input', help='Input C file with Cilk Plus')
-    parser.add_argument('output', help='Output C file with OpenMP SIMD')
+    parser.add_argument('input', nargs='+',
+                        help='Input C file with Cilk Plus; several files or directories convert in batch mode')
+    parser.add_argument('output', help='Output C file with OpenMP SIMD, or the output directory in batch mode')
     parser.add_argument('--log', default='cilk_convert.log', help='Log file for warnings')
+    parser.add_argument('--cilk-for-schedule', choices=['dynamic', 'guided'], default='dynamic',
+                        help='OpenMP schedule for converted cilk_for loops')
+    parser.add_argument('--jobs', '-j', type=int, metavar='N',
+                        help='Worker processes in batch mode (default: CPU count)')
+    parser.add_argument('--cache', metavar='DIR',
+                        help='Reuse batch results for unchanged files, keyed by content hash')
 
     args = parser.parse_args()
-
-    converter = CilkConverter(log_file=args.log)
-    count = converter.convert_file(args.input, args.output)
+    options = dict(cilk_for_schedule=args.cilk_for_schedule)
+
+    if len(args.input) > 1 or Path(args.input[0]).is_dir():
+        batch = BatchConverter(partial(convert_job, options), __file__, options,
+                               jobs=args.jobs, cache_dir=args.cache)
+        batch.run(args.input, args.output)
+        batch.write_log(args.log)
+        print(batch.summary())
+        print(f"Warnings written to {args.log}" if batch.warnings else "No warnings")
+        if batch.failed:
+            print(f"{len(batch.failed)} files failed to convert: {', '.join(batch.failed)}")
+            sys.exit(1)
+        return
+
+    converter = CilkConverter(log_file=args.log, **options)
+    count = converter.convert_file(args.input[0], args.output)
     converter.write_log()
 
     print(f"Converted {count} Cilk Plus constructs")
@@ -0,0 +1,1415 @@
+/*
+ * Native Cilk Plus array notation to OpenMP SIMD converter (tree-sitter C API)
+ *
+ * Converts the same constructs as cilk_to_openmp_treesitter.py without
+ * options, and emits the same text for them: section assignments, the
+ * __sec_reduce_* reductions (max_ind/min_ind as two loops), masked appends
+ * (exclusive-scan packs) and other masked if statements (wrapped in a loop).
+ * The options, task constructs and reducers stay with the Python converter;
+ * a file using cilk_for/cilk_spawn/cilk_sync or a reducer is reported and
+ * not written.
+ *
+ * Each file is parsed once. Sections are the subscripts whose brackets hold
+ * start:length[:stride], read from the syntax tree, so brackets in comments
+ * and strings are left alone. A subscript that is a single macro defined as
+ * start:length[:stride] (vALL, by default 0:VLENGTH) is that section, and
+ * -D NAME=start:length[:stride] declares macros from headers. Lengths are
+ * compared token by token: a statement whose sections differ in length is
+ * logged and left unconverted instead of getting a VLENGTH loop.
+ *
+ * Given several files or a directory, files are converted by --jobs worker
+ * threads (default: one per CPU) into the same layout under the output
+ * directory, as with batch_convert.py. Outputs are only rewritten when
+ * their content changes.
+ *
+ * Build (tree-sitter and tree-sitter-c checkouts in $TS and $TSC):
+ *   gcc -O2 -o cilk_to_openmp_native -I$TS/lib/include -I$TS/lib/src \
+ *       scripts/cilk_to_openmp_native.c $TS/lib/src/lib.c $TSC/src/parser.c -lpthread
+ *
+ * Usage:
+ *   cilk_to_openmp_native input.c output.c [--log FILE] [-D NAME=start:length[:stride]]
+ *   cilk_to_openmp_native src/ converted/ [--jobs N] [--log FILE] [-D ...]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+#include <tree_sitter/api.h>
+
+const TSLanguage *tree_sitter_c(void);
+
+#define LENGTH_VAR "VLENGTH"
+#define DEFAULT_LOG "cilk_convert_native.log"
+
+// ---------------------------------------------------------------------------
+// Strings
+
+typedef struct {
+    const char *p;
+    size_t n;
+} str;
+
+typedef struct {
+    char *data;
+    size_t len, cap;
+} buf;
+
+static void *xrealloc(void *p, size_t size) {
+    p = realloc(p, size ? size : 1);
+    if (!p) {
+        fprintf(stderr, "cilk_to_openmp_native: out of memory\n");
+        exit(2);
+    }
+    return p;
+}
+
+#define GROW(array, count, cap) do {                                        \
+        if ((count) == (cap)) {                                             \
+            (cap) = (cap) ? 2 * (cap) : 16;                                 \
+            (array) = xrealloc((array), sizeof(*(array)) * (cap));          \
+        }                                                                   \
+    } while (0)
+
+static void buf_add(buf *b, const char *s, size_t n) {
+    if (b->len + n + 1 > b->cap) {
+        b->cap = (b->len + n + 1) * 2;
+        b->data = xrealloc(b->data, b->cap);
+    }
+    memcpy(b->data + b->len, s, n);
+    b->len += n;
+    b->data[b->len] = '\0';
+}
+
+static void buf_str(buf *b, str s) {
+    buf_add(b, s.p, s.n);
+}
+
+static void buf_cstr(buf *b, const char *s) {
+    buf_add(b, s, strlen(s));
+}
+
+__attribute__((format(printf, 2, 3)))
+static void buf_printf(buf *b, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    char *tmp = xrealloc(NULL, (size_t)n + 1);
+    va_start(ap, fmt);
+    vsnprintf(tmp, (size_t)n + 1, fmt, ap);
+    va_end(ap);
+    buf_add(b, tmp, (size_t)n);
+    free(tmp);
+}
+
+static str buf_view(const buf *b) {
+    return (str){ b->data ? b->data : "", b->len };
+}
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+static bool is_word(char c) {
+    return isalnum((unsigned char)c) || c == '_';
+}
+
+static str trim(str s) {
+    while (s.n && is_space(s.p[0])) s.p++, s.n--;
+    while (s.n && is_space(s.p[s.n - 1])) s.n--;
+    return s;
+}
+
+static bool str_eq(str s, const char *t) {
+    return s.n == strlen(t) && memcmp(s.p, t, s.n) == 0;
+}
+
+static bool str_same(str a, str b) {
+    return a.n == b.n && memcmp(a.p, b.p, a.n) == 0;
+}
+
+static bool all_word(str s) {
+    if (!s.n) return false;
+    for (size_t i = 0; i < s.n; i++)
+        if (!is_word(s.p[i])) return false;
+    return true;
+}
+
+static bool is_blank(str s) {
+    return trim(s).n == 0;
+}
+
+// text without whitespace, except one space between two words
+static void normalize(buf *b, str text) {
+    for (size_t i = 0; i < text.n; i++) {
+        if (!is_space(text.p[i])) {
+            buf_add(b, text.p + i, 1);
+            continue;
+        }
+        while (i + 1 < text.n && is_space(text.p[i + 1])) i++;
+        if (b->len && is_word(b->data[b->len - 1]) && i + 1 < text.n && is_word(text.p[i + 1]))
+            buf_cstr(b, " ");
+    }
+}
+
+// True if e and f are the same tokens
+static bool same_tokens(str e, str f) {
+    buf a = { 0 }, b = { 0 };
+    normalize(&a, e);
+    normalize(&b, f);
+    bool same = str_same(buf_view(&a), buf_view(&b));
+    free(a.data);
+    free(b.data);
+    return same;
+}
+
+// True if text holds name as a whole word
+static bool has_word(str text, str name) {
+    for (size_t i = 0; i + name.n <= text.n; i++) {
+        if (memcmp(text.p + i, name.p, name.n) == 0 && (i == 0 || !is_word(text.p[i - 1])) &&
+            (i + name.n == text.n || !is_word(text.p[i + name.n])))
+            return true;
+    }
+    return false;
+}
+
+// expr unless it is a single identifier or literal, else (expr)
+static void buf_operand(buf *b, str expr) {
+    if (all_word(expr)) {
+        buf_str(b, expr);
+    } else {
+        buf_cstr(b, "(");
+        buf_str(b, expr);
+        buf_cstr(b, ")");
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Section macros: NAME=start:length[:stride]
+
+typedef struct {
+    char *name;
+    str part[3];
+    int parts;
+    char *text;
+} section_macro;
+
+// Splits start:length[:stride] into trimmed parts; false if it is not a section
+static bool split_section(str s, str part[3], int *parts) {
+    int n = 0;
+    size_t from = 0;
+    for (size_t i = 0; i <= s.n; i++) {
+        if (i < s.n && strchr("[]?;", s.p[i])) return false;
+        if (i == s.n || s.p[i] == ':') {
+            if (n == 3) return false;
+            part[n] = trim((str){ s.p + from, i - from });
+            if (!part[n].n) return false;
+            n++;
+            from = i + 1;
+        }
+    }
+    *parts = n;
+    return n >= 2;
+}
+
+static bool make_macro(section_macro *m, str name, str value) {
+    m->name = strndup(name.p, name.n);
+    m->text = strndup(value.p, value.n);
+    if (!split_section((str){ m->text, value.n }, m->part, &m->parts)) {
+        free(m->name);
+        free(m->text);
+        return false;
+    }
+    return true;
+}
+
+// -D macros, shared read-only by the workers
+static section_macro *global_macros;
+static size_t num_global_macros, cap_global_macros;
+
+// ---------------------------------------------------------------------------
+// Per-file conversion state
+
+enum { REC_SECTION, REC_IMPLICIT, REC_REDUCE };
+
+// A section, __sec_implicit_index call or __sec_reduce_* call, in document order
+typedef struct {
+    int kind;
+    uint32_t start, end;  // brackets of a section, else the call
+    str part[3];          // start, length, stride of a section
+    int parts;
+    int rank;             // implicit index: 0 if converted, else -1
+    int op;               // reduction: SEC_REDUCTIONS / SEC_INDEX_REDUCTIONS entry, -1 if unknown
+} record;
+
+typedef struct {
+    uint32_t start, end;
+    buf text;
+    int conversions, packs;
+} edit;
+
+typedef struct {
+    const char *path;
+    const char *src;
+    uint32_t len;
+    record *recs;
+    size_t nrecs, cap_recs;
+    edit *edits;
+    size_t nedits, cap_edits;
+    section_macro *macros;
+    size_t nmacros, cap_macros;
+    char **warnings;
+    size_t nwarnings, cap_warnings;
+    int conversions;  // of the statement being converted
+    int packs;
+    const char *unsupported;  // first task construct or reducer seen
+} file_ctx;
+
+__attribute__((format(printf, 2, 3)))
+static void warn(file_ctx *ctx, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    char *msg = xrealloc(NULL, (size_t)n + 1);
+    va_start(ap, fmt);
+    vsnprintf(msg, (size_t)n + 1, fmt, ap);
+    va_end(ap);
+    GROW(ctx->warnings, ctx->nwarnings, ctx->cap_warnings);
+    ctx->warnings[ctx->nwarnings++] = msg;
+}
+
+static str node_text(const file_ctx *ctx, TSNode node) {
+    uint32_t s = ts_node_start_byte(node), e = ts_node_end_byte(node);
+    return (str){ ctx->src + s, e - s };
+}
+
+static bool node_is(const file_ctx *ctx, TSNode node, const char *text) {
+    return !ts_node_is_null(node) && str_eq(node_text(ctx, node), text);
+}
+
+static bool type_is(TSNode node, const char *type) {
+    return !ts_node_is_null(node) && strcmp(ts_node_type(node), type) == 0;
+}
+
+static TSNode field(TSNode node, const char *name) {
+    return ts_node_child_by_field_name(node, name, (uint32_t)strlen(name));
+}
+
+static int line_of(TSNode node) {
+    return (int)ts_node_start_point(node).row + 1;
+}
+
+// Whitespace between the start of node's line and node
+static str get_indent(const file_ctx *ctx, TSNode node, buf *out) {
+    uint32_t start = ts_node_start_byte(node), i = start;
+    while (i > 0 && ctx->src[i - 1] != '\n') i--;
+    for (; i < start; i++)
+        if (ctx->src[i] == ' ' || ctx->src[i] == '\t') buf_add(out, ctx->src + i, 1);
+    return buf_view(out);
+}
+
+static const section_macro *find_macro(const file_ctx *ctx, str name) {
+    for (size_t i = ctx->nmacros; i-- > 0;)
+        if (str_eq(name, ctx->macros[i].name)) return &ctx->macros[i];
+    for (size_t i = num_global_macros; i-- > 0;)
+        if (str_eq(name, global_macros[i].name)) return &global_macros[i];
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Reductions
+
+// __sec_reduce_<op>: omp reduction identifier, initial value (NULL: the first
+// element) and loop body, as SEC_REDUCTIONS in the Python converter
+static const struct {
+    const char *name, *op, *init, *body;
+} sec_reductions[] = {
+    { "add", "+", "0", "{var} += {expr};" },
+    { "mul", "*", "1", "{var} *= {expr};" },
+    { "max", "max", NULL, "{var} = {expr} > {var} ? {expr} : {var};" },
+    { "min", "min", NULL, "{var} = {expr} < {var} ? {expr} : {var};" },
+    { "any_nonzero", "||", "0", "{var} = {var} || ({expr}) != 0;" },
+    { "any_zero", "||", "0", "{var} = {var} || ({expr}) == 0;" },
+    { "all_nonzero", "&&", "1", "{var} = {var} && ({expr}) != 0;" },
+    { "all_zero", "&&", "1", "{var} = {var} && ({expr}) == 0;" },
+    // _ind: the extreme value is reduced first, then the lowest index holding it
+    { "max_ind", "max", NULL, NULL },
+    { "min_ind", "min", NULL, NULL },
+};
+
+#define NUM_REDUCTIONS ((int)(sizeof(sec_reductions) / sizeof(sec_reductions[0])))
+
+static int reduction_op(str name) {
+    for (int k = 0; k < NUM_REDUCTIONS; k++)
+        if (str_eq(name, sec_reductions[k].name)) return k;
+    return -1;
+}
+
+static int value_op(int k) {
+    return strcmp(sec_reductions[k].name, "max_ind") == 0 ? reduction_op((str){ "max", 3 }) :
+           reduction_op((str){ "min", 3 });
+}
+
+static void format_body(buf *b, const char *tmpl, str var, str expr) {
+    for (const char *c = tmpl; *c;) {
+        if (strncmp(c, "{var}", 5) == 0) {
+            buf_str(b, var);
+            c += 5;
+        } else if (strncmp(c, "{expr}", 6) == 0) {
+            buf_str(b, expr);
+            c += 6;
+        } else {
+            buf_add(b, c++, 1);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Records: collected as the walk leaves each node
+
+static void note_subscript(file_ctx *ctx, TSNode node) {
+    uint32_t open = 0, close = 0;
+    bool has_open = false;
+    uint32_t count = ts_node_child_count(node);
+    for (uint32_t c = 0; c < count; c++) {
+        TSNode child = ts_node_child(node, c);
+        if (ts_node_is_named(child)) continue;
+        if (type_is(child, "[") && !has_open) {
+            open = ts_node_start_byte(child);
+            has_open = true;
+        } else if (type_is(child, "]")) {
+            close = ts_node_start_byte(child);
+        }
+    }
+    if (!has_open || close <= open) return;
+
+    record r = { .kind = REC_SECTION, .start = open, .end = close + 1 };
+    str inner = { ctx->src + open + 1, close - open - 1 };
+    if (memchr(inner.p, ':', inner.n)) {
+        if (!split_section(inner, r.part, &r.parts)) return;
+    } else {
+        const section_macro *m = find_macro(ctx, trim(inner));
+        if (!m) return;
+        memcpy(r.part, m->part, sizeof(r.part));
+        r.parts = m->parts;
+    }
+    GROW(ctx->recs, ctx->nrecs, ctx->cap_recs);
+    ctx->recs[ctx->nrecs++] = r;
+}
+
+// Text inside the parentheses of an argument list
+static str arguments_text(const file_ctx *ctx, TSNode args) {
+    str s = node_text(ctx, args);
+    if (s.n < 2) return (str){ s.p, 0 };
+    return trim((str){ s.p + 1, s.n - 2 });
+}
+
+static void note_call(file_ctx *ctx, TSNode node) {
+    TSNode function = field(node, "function");
+    TSNode args = field(node, "arguments");
+    if (!type_is(function, "identifier") || ts_node_is_null(args)) return;
+    str name = node_text(ctx, function);
+    record r = { .start = ts_node_start_byte(node), .end = ts_node_end_byte(node) };
+    if (str_eq(name, "__sec_implicit_index")) {
+        r.kind = REC_IMPLICIT;
+        r.rank = str_eq(arguments_text(ctx, args), "0") ? 0 : -1;
+    } else if (name.n > 13 && memcmp(name.p, "__sec_reduce_", 13) == 0) {
+        r.kind = REC_REDUCE;
+        r.op = reduction_op((str){ name.p + 13, name.n - 13 });
+    } else {
+        return;
+    }
+    GROW(ctx->recs, ctx->nrecs, ctx->cap_recs);
+    ctx->recs[ctx->nrecs++] = r;
+}
+
+static void note_define(file_ctx *ctx, TSNode node) {
+    TSNode name = field(node, "name"), value = field(node, "value");
+    if (ts_node_is_null(name) || ts_node_is_null(value)) return;
+    str v = node_text(ctx, value);
+    for (size_t i = 0; i + 1 < v.n; i++) {
+        if (v.p[i] == '/' && (v.p[i + 1] == '/' || v.p[i + 1] == '*')) {
+            v.n = i;
+            break;
+        }
+    }
+    GROW(ctx->macros, ctx->nmacros, ctx->cap_macros);
+    if (make_macro(&ctx->macros[ctx->nmacros], node_text(ctx, name), trim(v))) ctx->nmacros++;
+}
+
+static const char *const task_keywords[] = {
+    "_Cilk_for", "cilk_for", "_Cilk_spawn", "cilk_spawn", "_Cilk_sync", "cilk_sync",
+    "CILK_C_REDUCER_OPADD", "CILK_C_REDUCER_OPMUL", "CILK_C_REDUCER_MAX", "CILK_C_REDUCER_MIN",
+    "CILK_C_DECLARE_REDUCER",
+};
+
+static void note_leaf(file_ctx *ctx, TSNode node) {
+    if (ctx->unsupported || !ts_node_is_named(node)) return;
+    str text = node_text(ctx, node);
+    for (size_t k = 0; k < sizeof(task_keywords) / sizeof(task_keywords[0]); k++)
+        if (str_eq(text, task_keywords[k])) ctx->unsupported = task_keywords[k];
+}
+
+// ---------------------------------------------------------------------------
+// Lowering of one statement, over the records [first, last) inside it
+
+typedef struct {
+    file_ctx *ctx;
+    TSNode node;
+    size_t first, last;
+    str indent;
+} stmt;
+
+// Element of a section at the loop induction: start + induction*stride
+static void section_index(buf *b, const record *r, const char *induction) {
+    str start = r->part[0];
+    if (strcmp(induction, "0") == 0) {
+        buf_str(b, start);
+        return;
+    }
+    if (!str_eq(start, "0")) {
+        buf_operand(b, start);
+        buf_cstr(b, " + ");
+    }
+    if (r->parts < 3 || str_eq(r->part[2], "1")) {
+        buf_cstr(b, induction);
+    } else {
+        buf_operand(b, (str){ induction, strlen(induction) });
+        buf_cstr(b, " * ");
+        buf_operand(b, r->part[2]);
+    }
+}
+
+// Source [from, to) with every section and rank-0 implicit index at induction
+static void render(buf *b, const stmt *s, uint32_t from, uint32_t to, const char *induction) {
+    const char *src = s->ctx->src;
+    uint32_t pos = from;
+    for (size_t k = s->first; k < s->last; k++) {
+        const record *r = &s->ctx->recs[k];
+        if (r->start < pos || r->end > to || r->kind == REC_REDUCE) continue;
+        if (r->kind == REC_IMPLICIT && r->rank != 0) continue;
+        buf_add(b, src + pos, r->start - pos);
+        if (r->kind == REC_SECTION) {
+            buf_cstr(b, "[");
+            section_index(b, r, induction);
+            buf_cstr(b, "]");
+        } else {
+            buf_cstr(b, induction);
+        }
+        pos = r->end;
+    }
+    buf_add(b, src + pos, to - pos);
+}
+
+static void render_str(buf *b, const stmt *s, str text, const char *induction) {
+    uint32_t from = (uint32_t)(text.p - s->ctx->src);
+    render(b, s, from, from + (uint32_t)text.n, induction);
+}
+
+// The first two lengths of the statement's sections that differ; false if they all agree
+static bool different_lengths(const stmt *s, str *a, str *b) {
+    const record *first = NULL;
+    for (size_t k = s->first; k < s->last; k++) {
+        const record *r = &s->ctx->recs[k];
+        if (r->kind != REC_SECTION) continue;
+        if (!first) {
+            first = r;
+        } else if (!same_tokens(first->part[1], r->part[1])) {
+            *a = first->part[1];
+            *b = r->part[1];
+            return true;
+        }
+    }
+    return false;
+}
+
+// The common length of the statement's sections, checked by convert_statement()
+static str section_extent(const stmt *s) {
+    for (size_t k = s->first; k < s->last; k++)
+        if (s->ctx->recs[k].kind == REC_SECTION) return s->ctx->recs[k].part[1];
+    return (str){ LENGTH_VAR, strlen(LENGTH_VAR) };
+}
+
+static bool has_records(const stmt *s, int kind) {
+    for (size_t k = s->first; k < s->last; k++)
+        if (s->ctx->recs[k].kind == kind && (kind != REC_REDUCE || s->ctx->recs[k].op >= 0)) return true;
+    return false;
+}
+
+// One SIMD loop with an optional prelude, lines after the first indented
+static void emit_loop(buf *b, const stmt *s, str prelude, str extent, str body, str clauses) {
+    if (prelude.n) {
+        buf_str(b, prelude);
+        buf_cstr(b, "\n");
+        buf_str(b, s->indent);
+    }
+    buf_cstr(b, "#pragma omp simd");
+    buf_str(b, clauses);
+    buf_cstr(b, "\n");
+    buf_str(b, s->indent);
+    buf_cstr(b, "for (int i = 0; i < ");
+    buf_str(b, extent);
+    buf_cstr(b, "; i++) {\n");
+    buf_str(b, s->indent);
+    buf_cstr(b, "    ");
+    buf_str(b, body);
+    buf_cstr(b, "\n");
+    buf_str(b, s->indent);
+    buf_cstr(b, "}");
+    s->ctx->conversions++;
+}
+
+// [type] var = __sec_reduce_<op>(expr); false if the statement has another shape
+static bool convert_reduction(buf *out, const stmt *s) {
+    file_ctx *ctx = s->ctx;
+    TSNode target, call;
+    str type_decl = { ctx->src + ts_node_start_byte(s->node), 0 };
+
+    if (type_is(s->node, "declaration")) {
+        TSNode declarator = field(s->node, "declarator");
+        if (!type_is(declarator, "init_declarator")) return false;
+        target = field(declarator, "declarator");
+        call = field(declarator, "value");
+        if (!type_is(target, "identifier")) return false;
+        // Only unsigned/long/int/double/float, each followed by whitespace
+        str prefix = { type_decl.p, ts_node_start_byte(target) - ts_node_start_byte(s->node) };
+        for (size_t i = 0; i < prefix.n;) {
+            size_t w = i;
+            while (w < prefix.n && is_word(prefix.p[w])) w++;
+            str word = { prefix.p + i, w - i };
+            if (!(str_eq(word, "unsigned") || str_eq(word, "long") || str_eq(word, "int") ||
+                  str_eq(word, "double") || str_eq(word, "float")) || w == prefix.n || !is_space(prefix.p[w]))
+                return false;
+            while (w < prefix.n && is_space(prefix.p[w])) w++;
+            i = w;
+        }
+        type_decl = prefix;
+    } else {
+        TSNode expr = ts_node_named_child(s->node, 0);
+        if (!type_is(expr, "assignment_expression")) return false;
+        target = field(expr, "left");
+        call = field(expr, "right");
+        if (!type_is(target, "identifier") || ts_node_start_byte(target) != ts_node_start_byte(s->node))
+            return false;
+    }
+    if (!type_is(call, "call_expression")) return false;
+
+    // var = call ; with nothing else around them
+    str assign = { ctx->src + ts_node_end_byte(target), ts_node_start_byte(call) - ts_node_end_byte(target) };
+    str tail = { ctx->src + ts_node_end_byte(call), ts_node_end_byte(s->node) - ts_node_end_byte(call) };
+    if (!str_eq(trim(assign), "=") || !str_eq(trim(tail), ";")) return false;
+
+    TSNode function = field(call, "function");
+    str name = node_text(ctx, function);
+    if (!type_is(function, "identifier") || name.n <= 13 || memcmp(name.p, "__sec_reduce_", 13) != 0)
+        return false;
+    int k = reduction_op((str){ name.p + 13, name.n - 13 });
+    str arg = arguments_text(ctx, field(call, "arguments"));
+    if (k < 0 || !arg.n) return false;
+    str extent = section_extent(s);
+
+    str var = node_text(ctx, target);
+    buf expr = { 0 }, first = { 0 }, body = { 0 }, prelude = { 0 }, clauses = { 0 };
+    render_str(&expr, s, arg, "i");
+    render_str(&first, s, arg, "0");
+
+    if (sec_reductions[k].body) {
+        format_body(&body, sec_reductions[k].body, var, buf_view(&expr));
+        buf_str(&prelude, type_decl);
+        buf_str(&prelude, var);
+        buf_cstr(&prelude, " = ");
+        if (sec_reductions[k].init) buf_cstr(&prelude, sec_reductions[k].init);
+        else buf_str(&prelude, buf_view(&first));
+        buf_cstr(&prelude, ";");
+        buf_printf(&clauses, " reduction(%s:%.*s)", sec_reductions[k].op, (int)var.n, var.p);
+        emit_loop(out, s, buf_view(&prelude), extent, buf_view(&body), buf_view(&clauses));
+    } else {
+        int v = value_op(k);
+        buf value_var = { 0 }, nan_var = { 0 };
+        buf_printf(&value_var, "%.*s_value", (int)var.n, var.p);
+        buf_printf(&nan_var, "%.*s_nan", (int)var.n, var.p);
+        // '+ 0' drops the qualifiers of const arrays
+        buf_printf(&prelude, "__typeof__((%.*s) + 0) %s = %.*s;\n%.*sint %s = 0;", (int)first.len,
+                   first.data ? first.data : "", value_var.data, (int)first.len, first.data ? first.data : "",
+                   (int)s->indent.n, s->indent.p, nan_var.data);
+        // Vector max/min drop NaN operands, so whether there is one is reduced alongside
+        format_body(&body, sec_reductions[v].body, buf_view(&value_var), buf_view(&expr));
+        buf_printf(&body, "\n%.*s    %s = %s || %s != %s;", (int)s->indent.n, s->indent.p, nan_var.data,
+                   nan_var.data, expr.data, expr.data);
+        buf_printf(&clauses, " reduction(%s:%s) reduction(||:%s)", sec_reductions[v].op, value_var.data,
+                   nan_var.data);
+        emit_loop(out, s, buf_view(&prelude), extent, buf_view(&body), buf_view(&clauses));
+        s->ctx->conversions++;  // the flag, a statement of its own in the Python converter
+
+        buf_cstr(out, "\n");
+        buf_str(out, s->indent);
+        prelude.len = 0;
+        body.len = 0;
+        clauses.len = 0;
+        buf_str(&prelude, type_decl);
+        buf_str(&prelude, var);
+        buf_cstr(&prelude, " = ");
+        buf_str(&prelude, extent);
+        buf_cstr(&prelude, ";");
+        // With a NaN the first one is taken, so the index stays in range
+        buf_printf(&body, "if ((%s ? %s != %s : %s == %s) && i < %.*s) %.*s = i;", nan_var.data, expr.data,
+                   expr.data, expr.data, value_var.data, (int)var.n, var.p, (int)var.n, var.p);
+        buf_printf(&clauses, " reduction(min:%.*s)", (int)var.n, var.p);
+        emit_loop(out, s, buf_view(&prelude), extent, buf_view(&body), buf_view(&clauses));
+        free(value_var.data);
+        free(nan_var.data);
+    }
+    free(expr.data);
+    free(first.data);
+    free(body.data);
+    free(prelude.data);
+    free(clauses.data);
+    return true;
+}
+
+static bool convert_assignment(buf *out, const stmt *s) {
+    TSNode expr = ts_node_named_child(s->node, 0);
+    if (!type_is(expr, "assignment_expression")) {
+        warn(s->ctx, "WARNING: section statement at line %d is not an assignment; left unconverted",
+             line_of(s->node));
+        return false;
+    }
+    str extent = section_extent(s);
+    buf body = { 0 };
+    render_str(&body, s, trim(node_text(s->ctx, s->node)), "i");
+    emit_loop(out, s, (str){ "", 0 }, extent, buf_view(&body), (str){ "", 0 });
+    free(body.data);
+    return true;
+}
+
+// Element condition of a masked if, as an int that is 0 or 1
+static void mask_condition(buf *out, const stmt *s) {
+    buf rendered = { 0 };
+    render_str(&rendered, s, node_text(s->ctx, field(s->node, "condition")), "i");
+    str c = trim(buf_view(&rendered));
+    c = c.n >= 2 ? trim((str){ c.p + 1, c.n - 2 }) : c;
+
+    bool comparison = c.n && c.p[0] == '!';
+    for (size_t i = 0; i < c.n && !comparison; i++) {
+        char a = c.p[i], b = i + 1 < c.n ? c.p[i + 1] : '\0';
+        comparison = a == '<' || a == '>' || (b == '=' && (a == '!' || a == '=')) ||
+                     (a == '&' && b == '&') || (a == '|' && b == '|');
+    }
+    if (comparison) {
+        buf_str(out, c);
+    } else {
+        // [\w.]+ optionally followed by one [...] without brackets inside
+        size_t i = 0;
+        while (i < c.n && (is_word(c.p[i]) || c.p[i] == '.')) i++;
+        bool simple = i > 0;
+        if (simple && i < c.n) {
+            simple = c.p[i] == '[' && c.p[c.n - 1] == ']';
+            for (size_t j = i + 1; simple && j + 1 < c.n; j++)
+                simple = c.p[j] != '[' && c.p[j] != ']';
+        }
+        if (simple) {
+            buf_str(out, c);
+        } else {
+            buf_cstr(out, "(");
+            buf_str(out, c);
+            buf_cstr(out, ")");
+        }
+        buf_cstr(out, " != 0");
+    }
+    free(rendered.data);
+}
+
+typedef struct {
+    str dst;
+    str value;
+} pack_store;
+
+// Counter of k++, ++k or k += 1; empty if statement is not one of them
+static str pack_increment(const file_ctx *ctx, TSNode statement) {
+    TSNode e = ts_node_named_child(statement, 0);
+    if (!type_is(statement, "expression_statement") || ts_node_named_child_count(statement) != 1)
+        return (str){ NULL, 0 };
+    if (type_is(e, "update_expression") && node_is(ctx, field(e, "operator"), "++") &&
+        type_is(field(e, "argument"), "identifier"))
+        return node_text(ctx, field(e, "argument"));
+    if (type_is(e, "assignment_expression") && node_is(ctx, field(e, "operator"), "+=") &&
+        type_is(field(e, "left"), "identifier") && node_is(ctx, field(e, "right"), "1"))
+        return node_text(ctx, field(e, "left"));
+    return (str){ NULL, 0 };
+}
+
+// dst[k] = value; or dst[k++] = value;
+static bool pack_store_of(const file_ctx *ctx, TSNode statement, pack_store *store, str *counter, bool *post) {
+    TSNode e = ts_node_named_child(statement, 0);
+    if (!type_is(statement, "expression_statement") || !type_is(e, "assignment_expression") ||
+        !node_is(ctx, field(e, "operator"), "="))
+        return false;
+    TSNode left = field(e, "left"), right = field(e, "right");
+    if (!type_is(left, "subscript_expression") || !type_is(field(left, "argument"), "identifier"))
+        return false;
+    TSNode index = field(left, "index");
+    *post = false;
+    if (type_is(index, "update_expression")) {
+        TSNode arg = field(index, "argument");
+        if (!node_is(ctx, field(index, "operator"), "++") || !type_is(arg, "identifier") ||
+            ts_node_start_byte(arg) != ts_node_start_byte(index))
+            return false;
+        index = arg;
+        *post = true;
+    }
+    if (!type_is(index, "identifier")) return false;
+    *counter = node_text(ctx, index);
+    store->dst = node_text(ctx, field(left, "argument"));
+    uint32_t from = ts_node_start_byte(right), to = ts_node_end_byte(statement) - 1;
+    store->value = trim((str){ ctx->src + from, to > from ? to - from : 0 });
+    return true;
+}
+
+// Masked append: counter and stores, or false if the if statement is not a pack
+static bool pack_statements(const stmt *s, str *counter, pack_store **stores, size_t *nstores) {
+    const file_ctx *ctx = s->ctx;
+    TSNode body = field(s->node, "consequence");
+    if (!ts_node_is_null(field(s->node, "alternative")) || ts_node_is_null(body)) return false;
+
+    TSNode *statements = NULL;
+    size_t n = 0, cap = 0;
+    if (type_is(body, "compound_statement")) {
+        uint32_t count = ts_node_named_child_count(body);
+        for (uint32_t c = 0; c < count; c++) {
+            TSNode child = ts_node_named_child(body, c);
+            if (type_is(child, "comment")) continue;
+            GROW(statements, n, cap);
+            statements[n++] = child;
+        }
+    } else {
+        GROW(statements, n, cap);
+        statements[n++] = body;
+    }
+
+    str increment = n ? pack_increment(ctx, statements[n - 1]) : (str){ NULL, 0 };
+    size_t m = increment.p ? n - 1 : n;
+    *stores = xrealloc(NULL, sizeof(pack_store) * (m ? m : 1));
+    bool ok = m > 0;
+    str first_counter = { NULL, 0 };
+    for (size_t k = 0; k < m && ok; k++) {
+        str index;
+        bool post;
+        ok = pack_store_of(ctx, statements[k], &(*stores)[k], &index, &post);
+        if (ok && increment.p) ok = str_same(index, increment) && !post;
+        else if (ok) ok = m == 1 && post;
+        if (ok && k == 0) first_counter = index;
+    }
+    free(statements);
+    if (!ok) {
+        free(*stores);
+        *stores = NULL;
+        return false;
+    }
+    *counter = first_counter;
+    *nstores = m;
+    return true;
+}
+
+// Each line of text on a new line, one level deeper unless it is blank
+static void indented_lines(buf *out, str text) {
+    size_t from = 0;
+    for (size_t i = 0; i <= text.n; i++) {
+        if (i < text.n && text.p[i] != '\n') continue;
+        str line = { text.p + from, i - from };
+        buf_cstr(out, is_blank(line) ? "\n" : "\n    ");
+        buf_str(out, line);
+        from = i + 1;
+    }
+}
+
+// A ++ on a scalar or struct field anywhere in the if statement
+static bool has_scalar_increment(TSNode node, const file_ctx *ctx) {
+    TSNode arg = field(node, "argument");
+    if (type_is(node, "update_expression") && node_is(ctx, field(node, "operator"), "++") &&
+        (type_is(arg, "identifier") || type_is(arg, "field_expression")))
+        return true;
+    uint32_t count = ts_node_named_child_count(node);
+    for (uint32_t c = 0; c < count; c++)
+        if (has_scalar_increment(ts_node_named_child(node, c), ctx)) return true;
+    return false;
+}
+
+static bool convert_if_statement(buf *out, const stmt *s) {
+    file_ctx *ctx = s->ctx;
+    str extent = section_extent(s);
+    str text = node_text(ctx, s->node);
+    int line = line_of(s->node);
+
+    str counter;
+    pack_store *stores = NULL;
+    size_t nstores = 0;
+    bool pack = pack_statements(s, &counter, &stores, &nstores);
+    buf *values = pack ? xrealloc(NULL, sizeof(buf) * nstores) : NULL;
+    bool in_place = false;
+    if (pack) {
+        // A pack destination the mask or a stored value also reads
+        buf reads = { 0 };
+        buf_str(&reads, node_text(ctx, field(s->node, "condition")));
+        for (size_t k = 0; k < nstores; k++) {
+            values[k] = (buf){ 0 };
+            render_str(&values[k], s, stores[k].value, "i");
+            buf_cstr(&reads, k ? " " : "");
+            buf_str(&reads, buf_view(&values[k]));
+        }
+        for (size_t k = 0; k < nstores; k++)
+            in_place = in_place || has_word(buf_view(&reads), stores[k].dst);
+        free(reads.data);
+    }
+
+    if (pack && !in_place) {
+        buf condition = { 0 };
+        mask_condition(&condition, s);
+        buf_printf(out, "#pragma omp simd reduction(inscan, +:%.*s)\n", (int)counter.n, counter.p);
+        buf_str(out, s->indent);
+        buf_cstr(out, "for (int i = 0; i < ");
+        buf_str(out, extent);
+        buf_cstr(out, "; i++) {\n");
+        buf_str(out, s->indent);
+        buf_printf(out, "    if (%s) {\n", condition.data);
+        for (size_t k = 0; k < nstores; k++) {
+            buf_str(out, s->indent);
+            buf_printf(out, "        %.*s[%.*s] = %s;\n", (int)stores[k].dst.n, stores[k].dst.p,
+                       (int)counter.n, counter.p, values[k].data ? values[k].data : "");
+        }
+        buf_str(out, s->indent);
+        buf_cstr(out, "    }\n");
+        buf_str(out, s->indent);
+        buf_printf(out, "    #pragma omp scan exclusive(%.*s)\n", (int)counter.n, counter.p);
+        buf_str(out, s->indent);
+        buf_printf(out, "    %.*s += %s;\n", (int)counter.n, counter.p, condition.data);
+        buf_str(out, s->indent);
+        buf_cstr(out, "}");
+        ctx->packs++;
+        ctx->conversions++;
+        free(condition.data);
+    } else if (pack || has_scalar_increment(s->node, ctx)) {
+        warn(ctx, "WARNING: conditional at line %d %s; kept as a scalar loop", line,
+             pack ? "packs in place" : "updates a counter outside a dst[k++] = value append");
+        buf rendered = { 0 };
+        render_str(&rendered, s, text, "i");
+        buf_cstr(out, "for (int i = 0; i < ");
+        buf_str(out, extent);
+        buf_cstr(out, "; i++) {\n");
+        buf_str(out, s->indent);
+        buf_cstr(out, "    ");
+        str r = buf_view(&rendered);
+        const char *nl = memchr(r.p, '\n', r.n);
+        size_t head = nl ? (size_t)(nl - r.p) : r.n;
+        buf_add(out, r.p, head);
+        if (nl) indented_lines(out, (str){ nl + 1, r.n - head - 1 });
+        buf_cstr(out, "\n");
+        buf_str(out, s->indent);
+        buf_cstr(out, "}");
+        ctx->conversions++;
+        free(rendered.data);
+    } else {
+        // Wrap the entire if block in the loop
+        buf rendered = { 0 };
+        render_str(&rendered, s, text, "i");
+        buf_cstr(out, "#pragma omp simd\n");
+        buf_str(out, s->indent);
+        buf_cstr(out, "for (int i = 0; i < ");
+        buf_str(out, extent);
+        buf_cstr(out, "; i++) {");
+        indented_lines(out, buf_view(&rendered));
+        buf_cstr(out, "\n");
+        buf_str(out, s->indent);
+        buf_cstr(out, "}");
+        ctx->conversions++;
+        free(rendered.data);
+    }
+
+    for (size_t k = 0; pack && k < nstores; k++) free(values[k].data);
+    free(values);
+    free(stores);
+    return true;
+}
+
+// Drops the edits from first_edit on and the warnings in [first_warning, nested_warnings)
+static void drop_nested(file_ctx *ctx, size_t first_edit, size_t first_warning, size_t nested_warnings) {
+    for (size_t k = first_edit; k < ctx->nedits; k++) free(ctx->edits[k].text.data);
+    ctx->nedits = first_edit;
+    if (nested_warnings > first_warning) {
+        for (size_t k = first_warning; k < nested_warnings; k++) free(ctx->warnings[k]);
+        memmove(ctx->warnings + first_warning, ctx->warnings + nested_warnings,
+                sizeof(char *) * (ctx->nwarnings - nested_warnings));
+        ctx->nwarnings -= nested_warnings - first_warning;
+    }
+}
+
+// Converts a statement the walk has just left; it replaces the edits of the
+// statements nested in it, and the warnings they logged
+static void convert_statement(file_ctx *ctx, TSNode node, size_t first_rec, size_t first_edit,
+                              size_t first_warning) {
+    const char *type = ts_node_type(node);
+    bool declaration = strcmp(type, "declaration") == 0;
+    bool expression = strcmp(type, "expression_statement") == 0;
+    bool conditional = strcmp(type, "if_statement") == 0;
+    if (!declaration && !expression && !conditional) return;
+
+    buf indent = { 0 };
+    stmt s = { ctx, node, first_rec, ctx->nrecs, { "", 0 } };
+    bool sections = has_records(&s, REC_SECTION);
+    if (!sections) return;
+    s.indent = get_indent(ctx, node, &indent);
+
+    // Over sections of different lengths the statement has no one trip count;
+    // it stays as written, statements nested in it included, as in the Python
+    // converter
+    str a, b;
+    if (different_lengths(&s, &a, &b)) {
+        drop_nested(ctx, first_edit, first_warning, ctx->nwarnings);
+        warn(ctx, "WARNING: sections at line %d have different lengths (%.*s, %.*s); left unconverted",
+             line_of(node), (int)a.n, a.p, (int)b.n, b.p);
+        free(indent.data);
+        return;
+    }
+
+    buf out = { 0 };
+    bool converted = false;
+    size_t nested_warnings = ctx->nwarnings;
+    ctx->conversions = ctx->packs = 0;
+    if (conditional) {
+        converted = convert_if_statement(&out, &s);
+    } else if (has_records(&s, REC_REDUCE)) {
+        converted = convert_reduction(&out, &s);
+        if (!converted)
+            warn(ctx, "WARNING: reduction at line %d is not a '[type] var = __sec_reduce_<op>(...);' "
+                 "statement; left unconverted", line_of(node));
+    } else if (expression) {
+        converted = convert_assignment(&out, &s);
+    }
+
+    if (converted) {
+        drop_nested(ctx, first_edit, first_warning, nested_warnings);
+        GROW(ctx->edits, ctx->nedits, ctx->cap_edits);
+        ctx->edits[ctx->nedits++] = (edit){ ts_node_start_byte(node), ts_node_end_byte(node), out,
+                                            ctx->conversions, ctx->packs };
+    } else {
+        free(out.data);
+    }
+    free(indent.data);
+}
+
+// ---------------------------------------------------------------------------
+// One file
+
+// a[s:l] becomes a[s,l] so that the C grammar parses sections as subscripts;
+// the masked copy has the same length, so offsets index the original text
+static char *mask_sections(const char *src, uint32_t len) {
+    char *masked = xrealloc(NULL, len + 1);
+    memcpy(masked, src, len);
+    masked[len] = '\0';
+    for (uint32_t i = 0; i < len; i++) {
+        if (src[i] != '[') continue;
+        uint32_t j = i + 1;
+        bool colon = false;
+        while (j < len && !strchr("[]?;", src[j])) colon |= src[j++] == ':';
+        if (j < len && src[j] == ']' && colon) {
+            for (uint32_t k = i + 1; k < j; k++)
+                if (masked[k] == ':') masked[k] = ',';
+            i = j;
+        }
+    }
+    return masked;
+}
+
+typedef struct {
+    TSNode node;
+    size_t first_rec, first_edit, first_warning;
+} frame;
+
+// Walks the tree once, noting records on the way out of each node and
+// converting the outermost section statements
+static void walk(file_ctx *ctx, TSTree *tree) {
+    TSTreeCursor cursor = ts_tree_cursor_new(ts_tree_root_node(tree));
+    frame *stack = NULL;
+    size_t depth = 0, cap = 0;
+
+    for (;;) {
+        TSNode node = ts_tree_cursor_current_node(&cursor);
+        GROW(stack, depth, cap);
+        stack[depth++] = (frame){ node, ctx->nrecs, ctx->nedits, ctx->nwarnings };
+        if (ts_tree_cursor_goto_first_child(&cursor)) continue;
+
+        // Leave nodes until one has a next sibling
+        for (;;) {
+            frame f = stack[--depth];
+            const char *type = ts_node_type(f.node);
+            if (ts_node_child_count(f.node) == 0) note_leaf(ctx, f.node);
+            if (strcmp(type, "subscript_expression") == 0) note_subscript(ctx, f.node);
+            else if (strcmp(type, "call_expression") == 0) note_call(ctx, f.node);
+            else if (strcmp(type, "preproc_def") == 0) note_define(ctx, f.node);
+            else convert_statement(ctx, f.node, f.first_rec, f.first_edit, f.first_warning);
+
+            if (depth == 0) {
+                ts_tree_cursor_delete(&cursor);
+                free(stack);
+                return;
+            }
+            if (ts_tree_cursor_goto_next_sibling(&cursor)) break;
+            ts_tree_cursor_goto_parent(&cursor);
+        }
+    }
+}
+
+static bool covered(const file_ctx *ctx, const record *r) {
+    for (size_t k = 0; k < ctx->nedits; k++)
+        if (ctx->edits[k].start <= r->start && r->end <= ctx->edits[k].end) return true;
+    return false;
+}
+
+typedef struct {
+    const char *input;
+    char *output;
+    int conversions;
+    int packs;
+    int warnings;
+    buf log;
+    bool failed;
+} job;
+
+static bool read_file(const char *path, char **data, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    buf b = { 0 };
+    char chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) buf_add(&b, chunk, n);
+    bool ok = !ferror(f);
+    fclose(f);
+    *data = b.data ? b.data : strdup("");
+    *len = b.len;
+    return ok;
+}
+
+static int make_parents(const char *path) {
+    char *copy = strdup(path);
+    for (char *p = copy + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (mkdir(copy, 0777) != 0 && errno != EEXIST) {
+            free(copy);
+            return -1;
+        }
+        *p = '/';
+    }
+    free(copy);
+    return 0;
+}
+
+// Writes data unless path already holds exactly that
+static bool write_if_changed(const char *path, const char *data, size_t len) {
+    char *old;
+    size_t old_len;
+    if (read_file(path, &old, &old_len)) {
+        bool same = old_len == len && memcmp(old, data, len) == 0;
+        free(old);
+        if (same) return true;
+    }
+    if (make_parents(path) != 0) return false;
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+    bool ok = fwrite(data, 1, len, f) == len;
+    return fclose(f) == 0 && ok;
+}
+
+static void convert_file(TSParser *parser, job *j) {
+    file_ctx ctx = { .path = j->input };
+    char *source;
+    size_t len;
+    if (!read_file(j->input, &source, &len) || len > UINT32_MAX) {
+        warn(&ctx, "ERROR: cannot read %s", j->input);
+        j->failed = true;
+        goto done;
+    }
+    ctx.src = source;
+    ctx.len = (uint32_t)len;
+
+    char *masked = mask_sections(source, ctx.len);
+    TSTree *tree = ts_parser_parse_string(parser, NULL, masked, ctx.len);
+    walk(&ctx, tree);
+    ts_tree_delete(tree);
+    free(masked);
+
+    if (ctx.unsupported) {
+        warn(&ctx, "ERROR: %s is not supported by the native converter; "
+             "convert this file with cilk_to_openmp_treesitter.py", ctx.unsupported);
+        j->failed = true;
+    } else {
+        for (size_t k = 0; k < ctx.nrecs; k++) {
+            const record *r = &ctx.recs[k];
+            if (r->kind == REC_IMPLICIT && (r->rank != 0 || !covered(&ctx, r))) {
+                warn(&ctx, "WARNING: __sec_implicit_index is only converted for rank 0 of a section statement");
+                break;
+            }
+        }
+        buf result = { 0 };
+        uint32_t pos = 0;
+        for (size_t k = 0; k < ctx.nedits; k++) {
+            j->conversions += ctx.edits[k].conversions;
+            j->packs += ctx.edits[k].packs;
+            buf_add(&result, source + pos, ctx.edits[k].start - pos);
+            buf_str(&result, buf_view(&ctx.edits[k].text));
+            pos = ctx.edits[k].end;
+        }
+        buf_add(&result, source + pos, ctx.len - pos);
+        if (!write_if_changed(j->output, result.data, result.len)) {
+            warn(&ctx, "ERROR: cannot write %s", j->output);
+            j->failed = true;
+        }
+        free(result.data);
+    }
+
+done:
+    j->warnings = (int)ctx.nwarnings;
+    for (size_t k = 0; k < ctx.nwarnings; k++) {
+        buf_cstr(&j->log, ctx.warnings[k]);
+        buf_cstr(&j->log, "\n");
+        free(ctx.warnings[k]);
+    }
+    free(ctx.warnings);
+    for (size_t k = 0; k < ctx.nedits; k++) free(ctx.edits[k].text.data);
+    for (size_t k = 0; k < ctx.nmacros; k++) {
+        free(ctx.macros[k].name);
+        free(ctx.macros[k].text);
+    }
+    free(ctx.edits);
+    free(ctx.recs);
+    free(ctx.macros);
+    free(source);
+}
+
+// ---------------------------------------------------------------------------
+// Batch mode
+
+typedef struct {
+    job *jobs;
+    size_t count;
+    atomic_size_t next;
+} pool;
+
+static void *worker(void *arg) {
+    pool *p = arg;
+    TSParser *parser = ts_parser_new();
+    ts_parser_set_language(parser, tree_sitter_c());
+    for (size_t k; (k = atomic_fetch_add(&p->next, 1)) < p->count;) convert_file(parser, &p->jobs[k]);
+    ts_parser_delete(parser);
+    return NULL;
+}
+
+static void run_jobs(job *jobs, size_t count, int threads) {
+    pool p = { jobs, count, 0 };
+    if (threads > (int)count) threads = (int)count;
+    if (threads <= 1) {
+        worker(&p);
+        return;
+    }
+    pthread_t *ids = xrealloc(NULL, sizeof(pthread_t) * (size_t)threads);
+    for (int t = 0; t < threads; t++) pthread_create(&ids[t], NULL, worker, &p);
+    for (int t = 0; t < threads; t++) pthread_join(ids[t], NULL);
+    free(ids);
+}
+
+static bool is_dir(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+static char *join_path(const char *dir, const char *name) {
+    size_t n = strlen(dir);
+    char *path = xrealloc(NULL, n + strlen(name) + 2);
+    sprintf(path, "%s%s%s", dir, n && dir[n - 1] == '/' ? "" : "/", name);
+    return path;
+}
+
+typedef struct {
+    job *jobs;
+    size_t count, cap;
+    char *output_real;  // realpath of the output directory, skipped while collecting
+} job_list;
+
+static void add_job(job_list *list, const char *input, char *output) {
+    GROW(list->jobs, list->count, list->cap);
+    list->jobs[list->count++] = (job){ .input = strdup(input), .output = output };
+}
+
+static bool source_suffix(const char *name) {
+    size_t n = strlen(name);
+    return n > 2 && name[n - 2] == '.' && (name[n - 1] == 'c' || name[n - 1] == 'h');
+}
+
+static int compare_names(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// Source files under dir, keeping their layout below out
+static void collect(job_list *list, const char *dir, const char *out) {
+    char *real = realpath(dir, NULL);
+    bool inside_output = real && list->output_real && strcmp(real, list->output_real) == 0;
+    free(real);
+    DIR *d = inside_output ? NULL : opendir(dir);
+    if (!d) return;
+
+    char **names = NULL;
+    size_t n = 0, cap = 0;
+    for (struct dirent *e; (e = readdir(d));) {
+        if (e->d_name[0] == '.') continue;
+        GROW(names, n, cap);
+        names[n++] = strdup(e->d_name);
+    }
+    closedir(d);
+    qsort(names, n, sizeof(char *), compare_names);
+
+    for (size_t k = 0; k < n; k++) {
+        char *path = join_path(dir, names[k]);
+        char *dst = join_path(out, names[k]);
+        struct stat st;
+        if (stat(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+            collect(list, path, dst);
+            free(dst);
+        } else if (S_ISREG(st.st_mode) && source_suffix(names[k])) {
+            add_job(list, path, dst);
+        } else {
+            free(dst);
+        }
+        free(path);
+        free(names[k]);
+    }
+    free(names);
+}
+
+static void usage(FILE *f) {
+    fprintf(f, "usage: cilk_to_openmp_native input.c output.c [--log FILE] [-D NAME=start:length[:stride]]\n"
+               "       cilk_to_openmp_native INPUT... OUTPUT_DIR [--jobs N] [--log FILE] [-D ...]\n");
+}
+
+int main(int argc, char **argv) {
+    const char *log_path = DEFAULT_LOG;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    char **paths = xrealloc(NULL, sizeof(char *) * (size_t)argc);
+    int npaths = 0;
+
+    GROW(global_macros, num_global_macros, cap_global_macros);
+    make_macro(&global_macros[num_global_macros++], (str){ "vALL", 4 }, (str){ "0:" LENGTH_VAR, 2 + strlen(LENGTH_VAR) });
+
+    for (int a = 1; a < argc; a++) {
+        const char *arg = argv[a];
+        if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            usage(stdout);
+            return 0;
+        } else if ((strcmp(arg, "--log") == 0 || strcmp(arg, "--jobs") == 0 || strcmp(arg, "-j") == 0 ||
+                    strcmp(arg, "-D") == 0) && a + 1 < argc) {
+            const char *value = argv[++a];
+            if (strcmp(arg, "--log") == 0) {
+                log_path = value;
+            } else if (strcmp(arg, "-D") == 0) {
+                const char *eq = strchr(value, '=');
+                GROW(global_macros, num_global_macros, cap_global_macros);
+                if (!eq || !make_macro(&global_macros[num_global_macros], (str){ value, (size_t)(eq - value) },
+                                       (str){ eq + 1, strlen(eq + 1) })) {
+                    fprintf(stderr, "cilk_to_openmp_native: -D %s is not NAME=start:length[:stride]\n", value);
+                    return 2;
+                }
+                num_global_macros++;
+            } else {
+                char *end;
+                threads = strtol(value, &end, 10);
+                if (*end || threads <= 0) {
+                    fprintf(stderr, "cilk_to_openmp_native: --jobs must be a positive number\n");
+                    return 2;
+                }
+            }
+        } else if (arg[0] == '-' && arg[1]) {
+            usage(stderr);
+            return 2;
+        } else {
+            paths[npaths++] = argv[a];
+        }
+    }
+    if (npaths < 2) {
+        usage(stderr);
+        return 2;
+    }
+
+    const char *output = paths[npaths - 1];
+    bool batch = npaths > 2 || is_dir(paths[0]);
+    job_list list = { 0 };
+    if (!batch) {
+        add_job(&list, paths[0], strdup(output));
+    } else {
+        mkdir(output, 0777);
+        list.output_real = realpath(output, NULL);
+        for (int k = 0; k < npaths - 1; k++) {
+            if (is_dir(paths[k])) {
+                collect(&list, paths[k], output);
+            } else {
+                const char *base = strrchr(paths[k], '/');
+                add_job(&list, paths[k], join_path(output, base ? base + 1 : paths[k]));
+            }
+        }
+    }
+
+    run_jobs(list.jobs, list.count, (int)threads);
+
+    int conversions = 0, packs = 0, warnings = 0;
+    size_t failed = 0;
+    FILE *log = fopen(log_path, "w");
+    for (size_t k = 0; k < list.count; k++) {
+        job *j = &list.jobs[k];
+        conversions += j->conversions;
+        packs += j->packs;
+        warnings += j->warnings;
+        failed += j->failed;
+        // Batch logs prefix every line with its file, like batch_convert.py
+        for (const char *line = j->log.data; log && line && *line;) {
+            const char *nl = strchr(line, '\n');
+            if (batch) fprintf(log, "%s: ", j->input);
+            fprintf(log, "%.*s\n", (int)(nl - line), line);
+            line = nl + 1;
+        }
+    }
+    if (log) {
+        if (!warnings) fprintf(log, "No warnings\n");
+        fclose(log);
+    }
+
+    if (batch) printf("Converted %d Cilk Plus constructs in %zu files\n", conversions, list.count);
+    else printf("Converted %d Cilk Plus constructs\n", conversions);
+    if (packs) printf("Pack loops (exclusive scan): %d\n", packs);
+    if (warnings) printf("Warnings: %d (see %s)\n", warnings, log_path);
+    if (failed) {
+        printf("%zu files failed to convert:", failed);
+        for (size_t k = 0, n = 0; k < list.count; k++)
+            if (list.jobs[k].failed) printf("%s %s", n++ ? "," : "", list.jobs[k].input);
+        printf("\n");
+    }
+
+    for (size_t k = 0; k < list.count; k++) {
+        free((char *)list.jobs[k].input);
+        free(list.jobs[k].output);
+        free(list.jobs[k].log.data);
+    }
+    free(list.jobs);
+    free(list.output_real);
+    free(paths);
+    return failed ? 1 : 0;
+}
@@ -4,32 +4,448 @@ Convert Cilk Plus to OpenMP SIMD using tree-sitter for proper AST parsing.
 
 Handles:
 1. Array assignments (single and multi-line)
-2. Reductions (__sec_reduce_add)
-3. Conditionals with vector comparisons (wraps entire if-block)
+2. Reductions: __sec_reduce_add/mul/max/min -> reduction(+/*/max/min),
+   any_nonzero/any_zero -> reduction(||), all_zero/all_nonzero ->
+   reduction(&&), max_ind/min_ind -> a value reduction then a min reduction
+   over the matching indices
+3. Conditionals with vector comparisons (wraps entire if-block, or with
+   --if-convert becomes branchless selects: mask ? then : else)
+4. Task parallelism: cilk_for -> omp parallel for with a dynamic or guided
+   schedule, cilk_spawn -> omp task, cilk_sync -> omp taskwait (also
+   inserted before returns, where Cilk syncs implicitly)
+5. Reducers: opadd/opmul/max/min reducers (C macros or C++ classes) become
+   plain variables with a reduction clause on each cilk_for that updates
+   them; custom C reducers get a '#pragma omp declare reduction' built from
+   their reduce and identity callbacks
+
+Masked appends, if (mask[0:n]) { dst[k++] = value; }, are packs (stream
+compaction): the counter becomes an inscan reduction and the loop an
+exclusive prefix sum whose stores vectorize as scatters, where the
+branch on k would keep it scalar. __sec_implicit_index(0) is the element's
+position in its section, the loop induction.
+
+With --fuse, adjacent independent assignments and reductions over the same
+extent are merged into one loop with a combined reduction clause, so each
+input array is loaded once per element instead of once per statement.
+
+With --vecmath libmvec|sleef, math functions called inside converted loops
+are redeclared "omp declare simd" after the includes so they vectorize
+through the backend's vector-ABI entry points; svml is selected by compiler
+flags and needs no declarations.
+
+With --fuse --scalar-replace, a local array that one statement of a fused
+loop assigns and only later statements of the same loop read becomes a
+scalar declared in the loop body, and its declaration is removed, so the
+element stays in a register instead of being stored and loaded again.
+
+With --arena, local VLAs with a runtime extent that sections use, such as
+double tmp[n];, are allocated from the thread's src/arena.h bump allocator
+instead of the stack, so large temporaries cannot overflow it; the block
+declaring them starts with ARENA_SCOPE, which releases them when it exits.
+
+With --tile N, runs of adjacent statements that could fuse over a runtime
+extent become a loop over tiles of N elements (512 doubles use 4 KB per
+array, so several arrays stay within L1) that runs each statement's own
+SIMD loop over the tile. Reductions accumulate across tiles. Tiling takes
+precedence over --fuse for those groups; extents known at compile time are
+fused, or left alone, as without --tile.
+
+With --simd-clauses, loops over VLENGTH or a power-of-two literal extent up
+to 64 get simdlen/safelen, fixed-size local arrays used in sections are
+declared _Alignas(64), and loops touching them get an aligned(...:64)
+clause, so the compiler needs no peel or remainder loop.
+
+With --unroll-constant, loops over VLENGTH or a literal extent up to 64
+are specialized for it. Those whose body calls a function the vectorizer
+has no vector variant for (anything but fabs, and the --vecmath backend's
+functions when one is selected) would run one scalar call per element
+under omp simd, so they become UNROLL(extent) loops (src/unroll.h) that
+GCC unrolls fully; GCC rejects "#pragma GCC unroll" next to "#pragma omp
+simd", so these loops are no longer SIMD loops. The others keep omp simd,
+with the simdlen/safelen of --simd-clauses when the extent is a vector
+width. Longer sections are left as plain omp simd loops.
+
+Sections may start at any offset and take a stride, a[start:len:stride]
+lowering to a[start + i*stride]. With --stride-versioning, loops over
+sections with a runtime stride are duplicated under "if (stride == 1)" so
+the common unit-stride case gets contiguous vector loads and stores, and
+the general loop (gathers/scatters) runs otherwise.
+
+With --if-convert, masked if/else blocks whose branches only assign
+sections become one loop of selects: the mask is computed once per element
+and each store is unconditional, so the compiler can use vector blends
+instead of branches or masked stores.
+
+With --backend vec, statements over whole VLENGTH double sections built
+from + - * /, log, exp, sqrt, fabs and __sec_reduce_add are emitted as
+src/vec.h vdouble8 calls (AVX-512, AVX/AVX2, NEON or scalar), so they get
+SIMD code whatever the compiler's vectorizer does; the rest stay omp simd
+loops.
+
+With --dispatch, every function other than main that contains converted
+sections is marked DISPATCH_CLONES (src/dispatch.h): GCC/Clang build it for
+AVX-512F, AVX2 and the baseline target and pick a clone at startup.
+
+With --verify-vectorization, the output is compiled with $CC (default gcc)
+and its vectorizer remarks (-fopt-info-vec-all, or -Rpass=loop-vectorize for
+clang); every converted SIMD loop that did not vectorize is logged with the
+compiler's reasons and the Cilk source line it came from, and the script
+exits with status 1.
+
+Given several files or a directory, the output is a directory: files are
+converted in parallel worker processes (--jobs N), and with --cache DIR an
+unchanged file (same content, converter version and options) is copied from
+the cache without being parsed.
+
+With --parallel-threshold N, loops over a runtime extent become
+"#pragma omp parallel for simd if(parallel: n >= N)", keeping their
+reductions, so large sections run across threads (build with -fopenmp).
+
+With --repro-sum, __sec_reduce_add over double sections adds element i into
+partial sum i % REPRO_LANES and combines the partial sums in a fixed order
+(src/reprosum.h), so the result is bit-identical at every vector width, in
+every dispatch clone and in scalar code. The loop over lanes still
+vectorizes; these sums are never fused or threaded. Integer sums are exact
+in any order and stay plain reductions.
 
 Usage:
-    uv run python scripts/cilk_to_openmp_treesitter.py input.c output.c [--log errors.log]
+    uv run python scripts/cilk_to_openmp_treesitter.py input.c output.c [--log errors.log] [--fuse]
+        [--vecmath none|libmvec|sleef|svml] [--simd-clauses] [--parallel-threshold N]
+        [--cilk-for-schedule dynamic|guided] [--stride-versioning] [--if-convert]
+        [--backend omp|vec] [--dispatch] [--repro-sum] [--tile N] [--scalar-replace] [--arena]
+        [--unroll-constant] [--verify-vectorization [--verify-cflags FLAGS]]
+    uv run python scripts/cilk_to_openmp_treesitter.py src/ converted/ [--jobs N] [--cache DIR] [options]
 """
 
+import os
 import re
 import sys
+import shlex
+import difflib
 import argparse
+import subprocess
+from functools import partial
 from pathlib import Path
 
 import tree_sitter_c as tsc
 from tree_sitter import Language, Parser
 
+from batch_convert import BatchConverter, write_if_changed
+
 # Initialize parser
 C_LANGUAGE = Language(tsc.language())
 parser = Parser(C_LANGUAGE)
 
 
+# a[vALL], a[start:length] or a[start:length:stride]; parts hold no brackets,
+# so a ternary's '?' or a nested subscript never reads as a section
+SECTION_PART = r'[^\[\]:;?]+'
+SECTION_PATTERN = rf'\[(vALL|{SECTION_PART}:{SECTION_PART}(?::{SECTION_PART})?)\]'
+
+# __sec_reduce_<op>: (omp reduction identifier, initial value, loop body).
+# Max and min start from the first element, so any element type works.
+SEC_REDUCTIONS = {
+    'add': ('+', '0', '{var} += {expr};'),
+    'mul': ('*', '1', '{var} *= {expr};'),
+    'max': ('max', None, '{var} = {expr} > {var} ? {expr} : {var};'),
+    'min': ('min', None, '{var} = {expr} < {var} ? {expr} : {var};'),
+    'any_nonzero': ('||', '0', '{var} = {var} || ({expr}) != 0;'),
+    'any_zero': ('||', '0', '{var} = {var} || ({expr}) == 0;'),
+    'all_nonzero': ('&&', '1', '{var} = {var} && ({expr}) != 0;'),
+    'all_zero': ('&&', '1', '{var} = {var} && ({expr}) == 0;'),
+}
+
+# __sec_reduce_<op>_ind: the extreme value is reduced first, then the lowest
+# index holding it, so both loops vectorize as plain reductions
+SEC_INDEX_REDUCTIONS = {'max_ind': 'max', 'min_ind': 'min'}
+
+SEC_REDUCE_PATTERN = (r'((?:(?:unsigned|long|int|double|float)\s+)+)?(\w+)\s*=\s*'
+                      r'__sec_reduce_(\w+)\s*\((.+)\)\s*;')
+
+# Functions with vector-ABI variants in both libmvec and SLEEF's GNU-ABI library
+VECTOR_MATH_FUNCTIONS = {
+    'log': 'double log(double);',
+    'exp': 'double exp(double);',
+    'pow': 'double pow(double, double);',
+    'sin': 'double sin(double);',
+    'cos': 'double cos(double);',
+}
+
+# Calls GCC vectorizes inline under omp simd for every target and flag set
+INLINE_VECTOR_FUNCTIONS = {'fabs'}
+
+# Keywords a loop body may follow with '(', not calls
+CALL_LIKE_KEYWORDS = {'if', 'for', 'while', 'switch', 'return', 'sizeof'}
+
+# Calls without side effects, safe to evaluate for every element of a blend
+BLEND_SAFE_FUNCTIONS = set(VECTOR_MATH_FUNCTIONS) | {
+    'fabs', 'sqrt', 'fmin', 'fmax', 'floor', 'ceil', 'fma', 'exp2', 'log2', 'log10',
+    'tan', 'atan', 'tanh', 'atan2',
+}
+
+# Section assignment inside a masked branch: lhs[section] [op]= rhs;
+BLEND_ASSIGNMENT = r'(\w+\s*\[[^\]]*\])\s*([-+*/]?)=(?!=)\s*(.+?)\s*;'
+
+# Masked append inside a pack: dst[counter++] = value; or dst[counter] = value;
+PACK_STORE = r'(\w+)\s*\[\s*(\w+)\s*(\+\+)?\s*\]\s*=(?!=)\s*(.+?)\s*;'
+# The counter update closing a pack of several stores: counter++; ++counter; counter += 1;
+PACK_INCREMENT = r'(?:(\w+)\s*\+\+|\+\+\s*(\w+)|(\w+)\s*\+=\s*1)\s*;'
+
+# ++ on a scalar, which no element of a vector loop may do on its own
+SCALAR_INCREMENT = r'\b\w+\s*\+\+|\+\+\s*\w+\b(?!\s*\[)'
+
+# Element index of the enclosing section; ranks above 0 (nested sections) are not converted
+IMPLICIT_INDEX = r'__sec_implicit_index\s*\(\s*0\s*\)'
+
+# Local array that can become a scalar: no static storage, no const, no initializer
+TEMPORARY_ARRAY_PATTERN = r'(double|float|int|long)\s+(\w+)\s*\[\s*\w+\s*\]\s*;'
+
+# Local variable-length array: type name[runtime extent];
+VARIABLE_ARRAY_PATTERN = r'(double|float|int|long)\s+(\w+)\s*\[\s*([^\[\];]+?)\s*\]\s*;'
+
+# Fixed-size local array declaration: [static] [const] type name[extent];
+LOCAL_ARRAY_PATTERN = r'(?:static\s+)?(?:const\s+)?(?:double|float|int|long)\s+(\w+)\s*\[\s*\w+\s*\]\s*;'
+
+ALIGNMENT = 64
+
+# Widest simdlen/safelen emitted for a literal extent: 64 lanes is a 512-bit
+# vector of bytes. Larger extents are trip counts, not vector widths.
+MAX_SIMDLEN = 64
+
+# Longest literal extent --unroll-constant unrolls fully; longer ones would be
+# thousands of scalar calls (and GCC caps "#pragma GCC unroll" below 65535)
+MAX_UNROLL_EXTENT = 64
+
+CILK_FOR = r'\b(?:_Cilk_for|cilk_for)\b'
+CILK_SPAWN = r'\b(?:_Cilk_spawn|cilk_spawn)\b'
+CILK_SYNC = r'\b(?:_Cilk_sync|cilk_sync)\b'
+
+# #pragma cilk grainsize = G, or grainsize(G)
+GRAINSIZE_PATTERN = r'#\s*pragma\s+cilk\s+grainsize\s*(?:=\s*(.+?)|\((.+)\))\s*'
+
+# Reducer hyperobjects: C macros CILK_C_REDUCER_<KIND>(name, type, init) and
+# C++ cilk::reducer_<kind><T> name(init) / cilk::reducer<cilk::op_<kind><T>> name(init)
+C_REDUCER = r'\bCILK_C_REDUCER_(OPADD|OPMUL|MAX|MIN)\s*\(\s*(\w+)\s*,\s*(\w+)\s*,\s*([^;]+?)\s*\)\s*;'
+CPP_REDUCER = (r'\bcilk::reducer(?:_(opadd|opmul|max|min)\s*<\s*([^<>;]+?)\s*>'
+               r'|\s*<\s*cilk::op_(add|mul|max|min)\s*<\s*([^<>;]+?)\s*>\s*>)'
+               r'\s*(\w+)\s*(?:\(\s*([^;]*?)\s*\))?\s*;')
+# CILK_C_DECLARE_REDUCER(T) name = CILK_C_INIT_REDUCER(T, reduce, identity, destroy, init);
+CUSTOM_C_REDUCER = (r'\bCILK_C_DECLARE_REDUCER\s*\(\s*([^)]+?)\s*\)\s*(\w+)\s*=\s*'
+                    r'CILK_C_INIT_REDUCER\s*\(\s*[^,]+,\s*(\w+)\s*,\s*(\w+)\s*,\s*(\w+)\s*,\s*([^;]*?)\s*\)\s*;')
+
+REDUCER_OPS = {'opadd': '+', 'add': '+', 'opmul': '*', 'mul': '*', 'max': 'max', 'min': 'min'}
+REDUCER_IDENTITY = {'+': '0', '*': '1'}
+
+# Type names accepted by the CILK_C_REDUCER_* macros
+C_REDUCER_TYPES = {
+    'char': 'char', 'uchar': 'unsigned char', 'schar': 'signed char', 'wchar_t': 'wchar_t',
+    'short': 'short', 'ushort': 'unsigned short', 'int': 'int', 'uint': 'unsigned int',
+    'unsigned': 'unsigned int', 'long': 'long', 'ulong': 'unsigned long',
+    'longlong': 'long long', 'ulonglong': 'unsigned long long',
+    'float': 'float', 'double': 'double', 'longdouble': 'long double',
+}
+
+VECMATH_LINK = {
+    'libmvec': '-lmvec',
+    'sleef': '-lsleefgnuabi',
+}
+
+# Vectorizer remarks: GCC -fopt-info-vec-all and clang -Rpass*=loop-vectorize
+GCC_REMARK = r'^(.+?):(\d+):\d+: (missed|optimized): (.*)$'
+CLANG_REMARK = r'^(.+?):(\d+):\d+: remark: (.*?) \[-Rpass(-missed|-analysis)?=loop-vectorize\]$'
+
+# --backend vec: operators and functions with a vdouble8 form in src/vec.h
+VEC_OPERATORS = {'+': 'vd8_add', '-': 'vd8_sub', '*': 'vd8_mul', '/': 'vd8_div'}
+VEC_FUNCTIONS = {'log': 'vd8_log', 'exp': 'vd8_exp', 'sqrt': 'vd8_sqrt', 'fabs': 'vd8_fabs'}
+
+# Expression tokens: numeric literal, identifier, or any other character
+VEC_TOKEN = r'\s*(?:((?:\d+\.?\d*|\.\d+)(?:[eE][-+]?\d+)?[fFlL]?)|(\w+)|(\S))'
+
+# Double arrays and pointers: double name[...], [const] double *[restrict] name
+DOUBLE_ARRAY_PATTERN = r'\bdouble\b\s*(?:\*\s*(?:(?:const|restrict|__restrict|__restrict__)\s+)*(\w+)|(\w+)\s*\[)'
+
+
+class SectionStatement:
+    """A Cilk Plus statement lowered to the body of an elementwise loop."""
+
+    def __init__(self, node, text, extent, body, reduction=None, prelude=None):
+        self.node = node            # tree-sitter node being replaced
+        self.text = text            # original source, used for dependence checks
+        self.extent = extent        # loop trip count, e.g. 'VLENGTH'
+        self.body = body            # loop body with sections rewritten to [start + i*stride]
+        self.reduction = reduction  # (op, var) for reductions, else None
+        self.prelude = prelude      # initializer emitted before the loop
+        self.comments = []          # comments that preceded it inside a fused group
+
+
+class Reducer:
+    """A Cilk Plus reducer lowered to a plain variable with an OpenMP reduction."""
+
+    def __init__(self, name, op, ctype, init, declaration, combiner=None, destroy=None):
+        self.name = name
+        self.op = op                    # reduction identifier: '+', '*', 'max', 'min' or custom
+        self.ctype = ctype              # C type of the view
+        self.init = init                # initial value of the variable
+        self.declaration = declaration  # reducer declaration text being replaced
+        self.combiner = combiner        # '#pragma omp declare reduction' for custom reducers
+        self.destroy = destroy          # destroy callback of a custom reducer, no longer called
+
+
+class VecExpression:
+    """Recursive-descent lowering of a section expression to src/vec.h calls.
+
+    Each parse method returns (code, is_vector). Scalar subexpressions keep
+    their source text and are broadcast with vd8_set1() where they meet a
+    vector operand, the point where C converts them to double anyway.
+    Anything vec.h has no form for raises ValueError.
+    """
+
+    def __init__(self, converter, text):
+        self.converter = converter
+        self.text = text
+        self.tokens = [(m.lastindex, m.group(m.lastindex), m.start(m.lastindex))
+                       for m in re.finditer(VEC_TOKEN, text)]
+        self.pos = 0
+
+    def lower(self):
+        result = self.sum()
+        if self.pos != len(self.tokens):
+            raise ValueError(f"unsupported '{self.peek()}'")
+        return result
+
+    def peek(self, ahead=0):
+        pos = self.pos + ahead
+        return self.tokens[pos][1] if pos < len(self.tokens) else None
+
+    def take(self, expected=None):
+        if self.pos == len(self.tokens) or (expected and self.peek() != expected):
+            raise ValueError(f"expected '{expected}'" if expected else 'unexpected end')
+        self.pos += 1
+        return self.tokens[self.pos - 1]
+
+    @staticmethod
+    def vector(operand):
+        code, is_vector = operand
+        return code if is_vector else f'vd8_set1({code})'
+
+    @staticmethod
+    def combine(op, left, right):
+        if not left[1] and not right[1]:
+            return f'{left[0]} {op} {right[0]}', False
+        return f'{VEC_OPERATORS[op]}({VecExpression.vector(left)}, {VecExpression.vector(right)})', True
+
+    def sum(self):
+        left = self.product()
+        while self.peek() in ('+', '-'):
+            op = self.take()[1]
+            left = self.combine(op, left, self.product())
+        return left
+
+    def product(self):
+        left = self.unary()
+        while self.peek() in ('*', '/'):
+            op = self.take()[1]
+            left = self.combine(op, left, self.unary())
+        return left
+
+    def unary(self):
+        if self.peek() == '+':
+            self.take()
+            return self.unary()
+        if self.peek() == '-':
+            self.take()
+            code, is_vector = self.unary()
+            return (f'vd8_neg({code})', True) if is_vector else (f'-{code}', False)
+        return self.primary()
+
+    def primary(self):
+        kind, value, start = self.take()
+        if kind == 1:
+            return value, False
+        if value == '(':
+            if self.peek() in ('double', 'float', 'int', 'long', 'unsigned', 'const'):
+                raise ValueError('cast')
+            code, is_vector = self.sum()
+            self.take(')')
+            return (code, True) if is_vector else (f'({code})', False)
+        if kind != 2:
+            raise ValueError(f"unsupported '{value}'")
+
+        if self.peek() == '(':
+            self.take()
+            args = [] if self.peek() == ')' else [self.sum()]
+            while self.peek() == ',':
+                self.take()
+                args.append(self.sum())
+            self.take(')')
+            if not any(is_vector for _, is_vector in args):
+                return f'{value}({", ".join(code for code, _ in args)})', False
+            if value not in VEC_FUNCTIONS or len(args) != 1:
+                raise ValueError(f"no vector form of '{value}'")
+            return f'{VEC_FUNCTIONS[value]}({self.vector(args[0])})', True
+
+        if self.peek() == '[':
+            open_start = self.take()[2]
+            depth = 1
+            while depth:
+                bracket = self.take()[1]
+                depth += {'[': 1, ']': -1}.get(bracket, 0)
+            subscript = self.text[open_start + 1:self.tokens[self.pos - 1][2]].strip()
+            section = re.fullmatch(SECTION_PATTERN, f'[{subscript}]')
+            if section and self.converter.is_vec_section(value, section.group(1)):
+                return f'vd8_load({value})', True
+            if section or self.converter.has_cilk_notation(subscript):
+                raise ValueError(f"section '{value}[{subscript}]' is not a full double section")
+            return f'{value}[{subscript}]', False
+
+        return value, False
+
+
 class TreeSitterCilkConverter:
-    def __init__(self, log_file=None):
+    def __init__(self, log_file=None, fuse=False, vecmath='none', simd_clauses=False,
+                 parallel_threshold=None, cilk_for_schedule='dynamic', stride_versioning=False,
+                 if_convert=False, backend='omp', dispatch=False, repro_sum=False, tile=None,
+                 scalar_replace=False, arena=False, unroll_constant=False):
         self.log_file = log_file
         self.warnings = []
         self.conversions = 0
+        self.fused_loops = 0
         self.length_var = 'VLENGTH'
+        self.fuse = fuse
+        self.vecmath = vecmath
+        self.vector_calls = set()
+        self.simd_clauses = simd_clauses
+        self.aligned_arrays = set()
+        self.parallel_threshold = parallel_threshold
+        self.parallel_loops = 0
+        self.cilk_for_schedule = cilk_for_schedule
+        self.reducers = {}
+        self.stride_versioning = stride_versioning
+        self.versioned_loops = 0
+        self.if_convert = if_convert
+        self.blended_loops = 0
+        self.backend = backend
+        self.global_arrays = set()
+        self.double_arrays = set()
+        self.vec_statements = 0
+        self.vec_fallbacks = 0
+        self.dispatch = dispatch
+        self.dispatched_functions = []
+        self.repro_sum = repro_sum
+        self.repro_sums = 0
+        self.line_origins = []
+        self.vectorized_loops = 0
+        self.unverified_loops = 0
+        self.pack_loops = 0
+        self.tile = tile
+        self.tiled_loops = 0
+        self.scalar_replace = scalar_replace
+        self.scalar_temporaries = []
+        self.arena = arena
+        self.arena_temporaries = []
+        self.unroll_constant = unroll_constant
+        self.unrolled_loops = 0
+        self.function = None
 
     def log(self, msg):
         self.warnings.append(msg)
@@ -50,61 +466,767 @@ class TreeSitterCilkConverter:
         indent = indent_bytes.decode('utf-8', errors='replace')
         return ''.join(c for c in indent if c in ' \t')
 
-    def replace_vall(self, text):
-        """Replace [vALL] and [0:VLENGTH] with [i]."""
-        text = re.sub(r'\[vALL\]', '[i]', text)
-        text = re.sub(r'\[0:VLENGTH\]', '[i]', text)
-        text = re.sub(r'\[\d+:(\w+)\]', '[i]', text)
-        return text
+    def section_parts(self, section):
+        """Split a section's contents into (start, length, stride); stride is None if omitted."""
+        if section == 'vALL':
+            return '0', self.length_var, None
+        parts = [p.strip() for p in section.split(':')]
+        return parts[0], parts[1], parts[2] if len(parts) > 2 else None
+
+    def operand(self, expr):
+        """Parenthesize expr unless it is a single identifier or literal."""
+        return expr if re.fullmatch(r'\w+', expr) else f'({expr})'
+
+    def section_index(self, section, induction='i'):
+        """Element index of a section at the loop induction: start + induction*stride."""
+        start, _, stride = self.section_parts(section)
+        if induction == '0':
+            return start
+        step = induction if stride in (None, '1') else f'{self.operand(induction)} * {self.operand(stride)}'
+        return step if start == '0' else f'{self.operand(start)} + {step}'
+
+    def replace_vall(self, text, induction='i'):
+        """Replace every section with the element it holds at the loop induction."""
+        text = re.sub(IMPLICIT_INDEX, induction, text)
+        return re.sub(SECTION_PATTERN, lambda m: f'[{self.section_index(m.group(1), induction)}]', text)
+
+    def runtime_strides(self, text):
+        """Strides of the sections in text that are not integer literals."""
+        strides = (self.section_parts(section)[2] for section in re.findall(SECTION_PATTERN, text))
+        return list(dict.fromkeys(k for k in strides if k is not None and not k.isdigit()))
+
+    def mask_cilk_syntax(self, source_bytes):
+        """Rewrite Cilk Plus syntax into same-length plain C for parsing.
+
+        a[s:l] becomes a[s,l], cilk_for becomes an ordinary for, and
+        cilk_spawn becomes a (void) cast so spawned calls stay inside their
+        statement. The masked copy has the same length as the source, so node
+        offsets still index the original text.
+        """
+        masked = re.sub(
+            rb'\[[^\[\]?;]*:[^\[\]?;]*\]',
+            lambda m: m.group(0).replace(b':', b','),
+            source_bytes
+        )
+        masked = re.sub(CILK_FOR.encode(), lambda m: b'for'.ljust(len(m.group(0))), masked)
+        return re.sub(CILK_SPAWN.encode(), lambda m: b'(void)'.ljust(len(m.group(0))), masked)
+
+    def has_cilk_keywords(self, text):
+        """Check if text contains Cilk Plus task parallelism keywords."""
+        return bool(re.search(f'{CILK_FOR}|{CILK_SPAWN}|{CILK_SYNC}', text))
 
     def has_cilk_notation(self, text):
         """Check if text contains Cilk Plus array notation."""
-        return bool(re.search(r'\[vALL\]|\[0:VLENGTH\]|\[\d+:\w+\]', text))
+        return bool(re.search(SECTION_PATTERN, text))
+
+    def section_extents(self, text):
+        """The distinct trip counts of the sections in text, in order of appearance.
+
+        Lengths are compared token by token, so n-1 and n - 1 are one extent.
+        """
+        extents = {}
+        for section in re.findall(SECTION_PATTERN, text):
+            length = self.section_parts(section)[1]
+            extents.setdefault(tuple(re.findall(r'\w+|\S', length)), length)
+        return list(extents.values())
+
+    def section_extent(self, text):
+        """Return the common trip count of all sections in text, or None if they differ.
+
+        Text without sections runs over the full vector length.
+        """
+        extents = self.section_extents(text)
+        if len(extents) > 1:
+            return None
+        return extents[0] if extents else self.length_var
+
+    def note_vector_calls(self, text):
+        """Record math functions called in a loop body for the vecmath prelude."""
+        for name in re.findall(r'\b(\w+)\s*\(', text):
+            if name in VECTOR_MATH_FUNCTIONS:
+                self.vector_calls.add(name)
+
+    def include_position(self, source_bytes, tree, what):
+        """Offset just after the last top-level #include, where preludes go."""
+        includes = [n for n in tree.root_node.children if n.type == 'preproc_include']
+        if includes:
+            return source_bytes.find(b'\n', includes[-1].end_byte - 1) + 1
+        self.log(f"WARNING: no #include found, {what} placed at top of file")
+        return 0
+
+    def vecmath_prelude(self, source_bytes, tree):
+        """Insert omp declare simd declarations after the last top-level #include."""
+        pos = self.include_position(source_bytes, tree, 'vector math declarations')
+        lines = ['', f'/* Vector math backend: {self.vecmath} (link with {VECMATH_LINK[self.vecmath]}) */']
+        for name in sorted(self.vector_calls):
+            lines.append('#pragma omp declare simd notinbranch')
+            lines.append(VECTOR_MATH_FUNCTIONS[name])
+        return (pos, pos, '\n'.join(lines) + '\n')
+
+    def vec_prelude(self, source_bytes, tree):
+        """Include src/vec.h after the last top-level #include, checking its width."""
+        pos = self.include_position(source_bytes, tree, 'the vec.h include')
+        lines = ['', f'/* Vector backend: src/vec.h, one vdouble8 per {self.length_var} section */']
+        if self.vecmath in VECMATH_LINK:
+            macro = f'VECMATH_{self.vecmath.upper()}'
+            lines += [f'#ifndef {macro}', f'#define {macro}', '#endif']
+        lines += ['#include "vec.h"',
+                  f'_Static_assert({self.length_var} == VEC_WIDTH, '
+                  f'"--backend vec output needs {self.length_var} == VEC_WIDTH");']
+        return (pos, pos, '\n'.join(lines) + '\n')
+
+    def dispatch_prelude(self, source_bytes, tree):
+        """Include src/dispatch.h after the last top-level #include."""
+        pos = self.include_position(source_bytes, tree, 'the dispatch.h include')
+        lines = ['', '/* Runtime ISA dispatch: DISPATCH_CLONES functions get AVX-512F/AVX2/default clones */',
+                 '#include "dispatch.h"']
+        return (pos, pos, '\n'.join(lines) + '\n')
+
+    def reprosum_prelude(self, source_bytes, tree):
+        """Include src/reprosum.h after the last top-level #include."""
+        pos = self.include_position(source_bytes, tree, 'the reprosum.h include')
+        lines = ['', '/* Reproducible sums: REPRO_LANES partial sums combined in a fixed order */',
+                 '#include "reprosum.h"']
+        return (pos, pos, '\n'.join(lines) + '\n')
+
+    def arena_prelude(self, source_bytes, tree):
+        """Include src/arena.h after the last top-level #include."""
+        pos = self.include_position(source_bytes, tree, 'the arena.h include')
+        lines = ['', '/* Section temporaries: thread-local 64-byte-aligned bump allocator */',
+                 '#include "arena.h"']
+        return (pos, pos, '\n'.join(lines) + '\n')
+
+    def unroll_prelude(self, source_bytes, tree):
+        """Include src/unroll.h after the last top-level #include."""
+        pos = self.include_position(source_bytes, tree, 'the unroll.h include')
+        lines = ['', '/* Compile-time extents: UNROLL(n) loops are unrolled fully */',
+                 '#include "unroll.h"']
+        return (pos, pos, '\n'.join(lines) + '\n')
+
+    def dispatch_function(self, source_bytes, node, replacements):
+        """Mark a function with converted sections DISPATCH_CLONES, unless it is main or inline."""
+        header = source_bytes[node.start_byte:node.child_by_field_name('body').start_byte].decode('utf-8')
+        match = re.match(r'[^(]*?(\w+)\s*\(', header)
+        if not match or match.group(1) == 'main' or re.search(r'\binline\b', header):
+            return
+        name = match.group(1)
+        replacements.append((node.start_byte, node.start_byte, 'DISPATCH_CLONES\n'))
+        self.dispatched_functions.append(name)
+
+    def array_names(self, text):
+        """Names declared in text as double arrays or pointers to double."""
+        return {a or b for a, b in re.findall(DOUBLE_ARRAY_PATTERN, text)}
+
+    def is_vec_section(self, name, section):
+        """True if name[section] is a whole double array section vec.h loads in one vdouble8."""
+        start, length, stride = self.section_parts(section)
+        return (name in self.double_arrays and start == '0' and length == self.length_var
+                and stride in (None, '1'))
+
+    def vec_statement(self, stmt):
+        """Lower stmt to one vec.h statement, or None if vec.h cannot express it."""
+        text = stmt.text.strip()
+        try:
+            if stmt.reduction:
+                match = re.match(SEC_REDUCE_PATTERN, text)
+                code, is_vector = VecExpression(self, match.group(4)).lower()
+                if match.group(3) != 'add' or not is_vector:
+                    return None
+                return f'{match.group(1) or ""}{match.group(2)} = vd8_reduce_add({code});'
+
+            match = re.fullmatch(r'(\w+)\s*' + SECTION_PATTERN + r'\s*([-+*/]?)=(?!=)\s*(.+?)\s*;', text, re.S)
+            if not match or not self.is_vec_section(match.group(1), match.group(2)):
+                return None
+            name, op = match.group(1), match.group(3)
+            value = VecExpression(self, match.group(4)).lower()
+            if op:
+                value = VecExpression.combine(op, (f'vd8_load({name})', True), value)
+            return f'vd8_store({name}, {VecExpression.vector(value)});'
+        except ValueError:
+            return None
+
+    def vec_lines(self, statements, indent):
+        """Emit statements as vec.h calls, or None if any of them needs a loop."""
+        lines = [self.vec_statement(s) for s in statements]
+        if not all(lines):
+            for stmt, line in zip(statements, lines):
+                if not line:
+                    self.log(f"NOTE: kept as an omp simd loop, vec.h covers +-*/ and "
+                             f"{'/'.join(VEC_FUNCTIONS)} on whole double sections and their "
+                             f"__sec_reduce_add: {' '.join(stmt.text.split())}")
+            self.vec_fallbacks += len(statements)
+            return None
+
+        result = []
+        for n, (stmt, line) in enumerate(zip(statements, lines)):
+            if stmt.comments:
+                if n > 0:
+                    result.append('')
+                result.extend(f'{indent}{c}' for c in stmt.comments)
+            result.append(f'{indent}{line}')
+        self.vec_statements += len(statements)
+        self.conversions += len(statements)
+        return '\n'.join(result)[len(indent):]
 
     def is_reduction(self, text):
-        """Check if text contains __sec_reduce_add."""
-        return '__sec_reduce_add' in text
+        """Check if text contains a supported __sec_reduce_* call."""
+        return any(op in SEC_REDUCTIONS or op in SEC_INDEX_REDUCTIONS
+                   for op in re.findall(r'__sec_reduce_(\w+)\s*\(', text))
 
-    def convert_reduction(self, text, indent):
-        """Convert __sec_reduce_add to OpenMP SIMD reduction."""
-        # Match: [type] var = __sec_reduce_add(expr[slice])
-        match = re.match(
-            r'((?:int|double|float)\s+)?(\w+)\s*=\s*__sec_reduce_add\((.+)\[(vALL|\d+:\w+)\]\)\s*;',
-            text.strip()
-        )
-        if not match:
+    def reduction_statement(self, node, text):
+        """Build the loop form of: [type] var = __sec_reduce_<op>(expr[slice])."""
+        match = re.match(SEC_REDUCE_PATTERN, text.strip())
+        if not match or match.group(3) not in SEC_REDUCTIONS:
             return None
 
         type_decl = match.group(1) or ''
         result_var = match.group(2)
-        array_expr = match.group(3)
+        expr = self.replace_vall(match.group(4).strip())
+        op, init, body = SEC_REDUCTIONS[match.group(3)]
+        if init is None:
+            init = self.replace_vall(match.group(4).strip(), induction='0')
 
-        result = [
-            f'{indent}{type_decl}{result_var} = 0;',
-            f'{indent}#pragma omp simd reduction(+:{result_var})',
-            f'{indent}for (int i = 0; i < {self.length_var}; i++) {{',
-            f'{indent}    {result_var} += {array_expr}[i];',
-            f'{indent}}}'
+        return SectionStatement(
+            node, text, self.section_extent(text),
+            body=body.format(var=result_var, expr=expr),
+            reduction=(op, result_var),
+            prelude=f'{type_decl}{result_var} = {init};'
+        )
+
+    def is_repro_sum(self, text):
+        """True if --repro-sum applies to text: a __sec_reduce_add into a double."""
+        match = re.match(SEC_REDUCE_PATTERN, text.strip())
+        if not self.repro_sum or not match or match.group(3) != 'add':
+            return False
+        if match.group(1):
+            return 'double' in match.group(1).split()
+        arrays = re.findall(r'(\w+)\s*' + SECTION_PATTERN.replace('(', '(?:', 1), match.group(4))
+        return any(name in self.double_arrays for name in arrays)
+
+    def repro_sum_lines(self, stmt, indent):
+        """Emit a reproducible __sec_reduce_add (src/reprosum.h).
+
+        Element i adds into lanes[i % REPRO_LANES] in index order and
+        repro_combine() adds the lanes pairwise, so vectorizing the lane loop
+        at any width reorders nothing. With --backend vec a whole VLENGTH
+        section still becomes vd8_reduce_add(), which sums in the same order.
+        """
+        if self.backend == 'vec':
+            vector = self.vec_lines([stmt], indent)
+            if vector:
+                return vector
+
+        match = re.match(SEC_REDUCE_PATTERN, stmt.text.strip())
+        var, expr = match.group(2), match.group(4).strip()
+        lanes = f'{var}_lanes'
+        extent = self.operand(stmt.extent)
+        body = f'{lanes}[lane] += {self.replace_vall(expr, induction="i + lane")};'
+        self.note_vector_calls(body)
+        lines = [
+            f'{indent}{stmt.prelude}',
+            f'{indent}{{',
+            f'{indent}    double {lanes}[REPRO_LANES] = {{0}};',
+            f'{indent}    int i = 0;',
+            f'{indent}    for (; i + REPRO_LANES <= {extent}; i += REPRO_LANES) {{',
+            f'{indent}        #pragma omp simd',
+            f'{indent}        for (int lane = 0; lane < REPRO_LANES; lane++) {{',
+            f'{indent}            {body}',
+            f'{indent}        }}',
+            f'{indent}    }}',
+            f'{indent}    for (int lane = 0; i < {extent}; i++, lane++) {{',
+            f'{indent}        {lanes}[lane] += {self.replace_vall(expr)};',
+            f'{indent}    }}',
+            f'{indent}    {var} += repro_combine({lanes});',
+            f'{indent}}}',
         ]
+        self.repro_sums += 1
         self.conversions += 1
-        return '\n'.join(result)
+        return '\n'.join(lines)[len(indent):]
+
+    def index_reduction_statements(self, text):
+        """Build the two loops of: [type] var = __sec_reduce_max_ind/min_ind(expr[slice]).
+
+        Returns the statements of each loop. The first loop reduces the
+        extreme value and whether any element is NaN, the second the lowest
+        index holding the value; ties resolve to the first element like a
+        serial scan. Vector max/min drop NaN operands, so the reduced value
+        cannot tell a NaN apart; with the flag set the second loop takes the
+        first NaN instead, which keeps the result in range (0 for an all-NaN
+        section) rather than the extent no element matched.
+        """
+        match = re.match(SEC_REDUCE_PATTERN, text.strip())
+        if not match or match.group(3) not in SEC_INDEX_REDUCTIONS:
+            return None
+
+        type_decl = match.group(1) or ''
+        result_var = match.group(2)
+        value_var = f'{result_var}_value'
+        expr = self.replace_vall(match.group(4).strip())
+        first = self.replace_vall(match.group(4).strip(), induction='0')
+        op = SEC_INDEX_REDUCTIONS[match.group(3)]
+        extent = self.section_extent(text)
+
+        nan_var = f'{result_var}_nan'
+        value = SectionStatement(
+            None, text, extent,
+            body=SEC_REDUCTIONS[op][2].format(var=value_var, expr=expr),
+            reduction=(op, value_var),
+            # '+ 0' drops the qualifiers of const arrays
+            prelude=f'__typeof__(({first}) + 0) {value_var} = {first};'
+        )
+        has_nan = SectionStatement(
+            None, text, extent,
+            body=f'{nan_var} = {nan_var} || {expr} != {expr};',
+            reduction=('||', nan_var),
+            prelude=f'int {nan_var} = 0;'
+        )
+        index = SectionStatement(
+            None, text, extent,
+            body=f'if (({nan_var} ? {expr} != {expr} : {expr} == {value_var}) && i < {result_var}) '
+                 f'{result_var} = i;',
+            reduction=('min', result_var),
+            prelude=f'{type_decl}{result_var} = {extent};'
+        )
+        return [[value, has_nan], [index]]
+
+    def assignment_statement(self, node, text):
+        """Build the loop form of: array[slice] = expr(other[slice])."""
+        return SectionStatement(
+            node, text, self.section_extent(text),
+            body=self.replace_vall(text.strip())
+        )
+
+    def is_dependence_free(self, body):
+        """True if every array the loop body writes is only accessed at [i]."""
+        for name in set(re.findall(r'\b(\w+)\[[^\]]*\]\s*[-+*/]?=(?!=)', body)):
+            for ref in re.finditer(rf'\b{re.escape(name)}\b\s*(\[[^\]]*\])?', body):
+                if ref.group(1) != '[i]':
+                    return False
+        return True
+
+    def is_constant_extent(self, extent):
+        return extent == self.length_var or extent.isdigit()
+
+    def is_vector_width(self, extent):
+        """True for VLENGTH or a power-of-two literal up to MAX_SIMDLEN, a valid simdlen."""
+        if extent == self.length_var:
+            return True
+        return extent.isdigit() and 0 < int(extent) <= MAX_SIMDLEN and int(extent) & (int(extent) - 1) == 0
+
+    def writes_only_elements(self, body, reductions):
+        """True if the body assigns nothing but [i] elements and reduction variables."""
+        reduced = {var for _, var in reductions}
+        for lhs, index in re.findall(r'\b(\w+)\s*(\[[^\]]*\])?\s*(?:[-+*/%&|^]|<<|>>)?=(?!=)', body):
+            if index != '[i]' and lhs not in reduced:
+                return False
+        return True
+
+    def is_unrolled(self, body, extent, tiled=False):
+        """True if --unroll-constant unrolls this loop fully instead of vectorizing it.
+
+        That is a loop over a compile-time extent calling a function without
+        a vector variant: vectorized, it would still make one scalar call per
+        element, in a loop. Run in order, its reductions need no clause.
+        Only VLENGTH and literals up to MAX_UNROLL_EXTENT are unrolled; a
+        longer section keeps its omp simd loop.
+        """
+        if not self.unroll_constant or tiled:
+            return False
+        if extent != self.length_var and not (extent.isdigit() and int(extent) <= MAX_UNROLL_EXTENT):
+            return False
+        vector = INLINE_VECTOR_FUNCTIONS | (set(VECTOR_MATH_FUNCTIONS) if self.vecmath != 'none' else set())
+        return any(name not in vector and name not in CALL_LIKE_KEYWORDS
+                   for name in re.findall(r'\b(\w+)\s*\(', body))
+
+    def simd_pragma(self, body, extent, reductions=(), tiled=False):
+        """Build the omp simd pragma for a loop body, with optional clauses.
+
+        simdlen/safelen are only emitted for extents that are a vector width
+        (is_vector_width()); a long literal section keeps a plain loop. Loops
+        over one tile of a --tile nest are never threaded and get no
+        simdlen/safelen: their trip count is at most the tile size. Loops
+        is_unrolled() picks get an UNROLL line instead.
+        """
+        if self.is_unrolled(body, extent, tiled):
+            self.unrolled_loops += 1
+            return f'UNROLL({extent})'
+        pragma = '#pragma omp simd'
+        if (self.parallel_threshold and not tiled and not self.is_constant_extent(extent)
+                and self.writes_only_elements(body, reductions)):
+            pragma = f'#pragma omp parallel for simd if(parallel: {extent} >= {self.parallel_threshold})'
+            self.parallel_loops += 1
+        if (self.simd_clauses or self.unroll_constant) and self.is_vector_width(extent) and not tiled:
+            pragma += f' simdlen({extent})'
+            if self.is_dependence_free(body):
+                pragma += f' safelen({extent})'
+        if self.simd_clauses:
+            aligned = [n for n in dict.fromkeys(re.findall(r'\b(\w+)\[i\]', body))
+                       if n in self.aligned_arrays]
+            if aligned:
+                pragma += f' aligned({",".join(aligned)}:{ALIGNMENT})'
+        for op in dict.fromkeys(op for op, _ in reductions):
+            names = ','.join(var for o, var in reductions if o == op)
+            pragma += f' reduction({op}:{names})'
+        return pragma
+
+    def align_local_arrays(self, source_bytes, function, replacements):
+        """Declare fixed-size local arrays used in sections _Alignas(64).
+
+        Returns the set of aligned names, for the aligned clause of loops in
+        this function.
+        """
+        text = source_bytes[function.start_byte:function.end_byte].decode('utf-8', errors='replace')
+        used = set(re.findall(r'(\w+)\s*' + SECTION_PATTERN.replace('(', '(?:', 1), text))
+        aligned = set()
+        stack = [function]
+        while stack:
+            node = stack.pop()
+            stack.extend(node.children)
+            if node.type != 'declaration':
+                continue
+            decl = source_bytes[node.start_byte:node.end_byte].decode('utf-8', errors='replace')
+            match = re.fullmatch(LOCAL_ARRAY_PATTERN, decl.strip())
+            if match and match.group(1) in used:
+                replacements.append((node.start_byte, node.start_byte, f'_Alignas({ALIGNMENT}) '))
+                aligned.add(match.group(1))
+        return aligned
+
+    def variable_arrays(self, source_bytes, block):
+        """The VLAs declared directly in block that sections use, for --arena.
+
+        Returns (declaration, type, name, extent) for each one whose extent
+        is a runtime value: it names a variable, not only upper-case macros.
+        These are added to the aligned clause arrays before the block's
+        statements are converted, since arena memory is 64-byte aligned.
+        """
+        text = self.node_text(source_bytes, block)
+        used = set(re.findall(r'(\w+)\s*' + SECTION_PATTERN.replace('(', '(?:', 1), text))
+        arrays = []
+        for child in block.named_children:
+            match = child.type == 'declaration' and re.fullmatch(
+                VARIABLE_ARRAY_PATTERN, self.node_text(source_bytes, child).strip())
+            if not match or match.group(2) not in used:
+                continue
+            ctype, name, extent = match.groups()
+            if all(word.isupper() for word in re.findall(r'[A-Za-z_]\w*', extent)):
+                continue
+            if re.search(rf'\bsizeof\s*\(?\s*{re.escape(name)}\b', text):
+                self.log(f"WARNING: {name}[{extent}] kept on the stack, sizeof({name}) is its array size")
+                continue
+            arrays.append((child, ctype, name, extent))
+            if self.simd_clauses:
+                self.aligned_arrays.add(name)
+        return arrays
+
+    def allocate_from_arena(self, source_bytes, block, arrays, replacements):
+        """Allocate the VLAs found by variable_arrays() from src/arena.h (--arena).
+
+        The block gets an ARENA_SCOPE first, so everything allocated in it is
+        released when it exits. Declarations --scalar-replace removed in the
+        meantime are left alone; other edits inside a declaration, such as the
+        _Alignas of --simd-clauses, are dropped.
+        """
+        allocated = []
+        for declaration, ctype, name, extent in arrays:
+            start, end = declaration.start_byte, declaration.end_byte
+            if any(r[0] <= start and end <= r[1] for r in replacements):
+                continue
+            replacements[:] = [r for r in replacements if not (start <= r[0] and r[1] <= end)]
+            replacements.append((start, end,
+                                 f'{ctype} *{name} = arena_alloc({extent}, sizeof({ctype}));'))
+            allocated.append(name)
+        if allocated:
+            indent = self.get_indent(source_bytes, arrays[0][0])
+            replacements.append((block.start_byte + 1, block.start_byte + 1, f'\n{indent}ARENA_SCOPE;'))
+            self.arena_temporaries.extend(allocated)
+
+    def loop_lines(self, statements, indent, unit_strides=(), tile=None, nested=''):
+        """Lines of the SIMD loop over statements, with unit_strides taken as 1.
+
+        tile, a (first, end) pair of variables, restricts the loop to one tile.
+        nested is the indentation the loop adds over the statement it replaces,
+        such as the tile loop or the stride check; continuation lines of a
+        body that spans several source lines are shifted by it too.
+        """
+        reductions = [s.reduction for s in statements if s.reduction]
+        bodies = [s.body for s in statements]
+        for stride in unit_strides:
+            bodies = [b.replace(f'i * {self.operand(stride)}', 'i') for b in bodies]
+        bodies = [b.replace('\n', f'\n{nested}') for b in bodies]
+
+        first, end = tile or ('0', statements[0].extent)
+        pragma = self.simd_pragma(chr(10).join(bodies), statements[0].extent, reductions, tiled=bool(tile))
+        lines = [f'{indent}{pragma}',
+                 f'{indent}for (int i = {first}; i < {end}; i++) {{']
+        for n, (stmt, body) in enumerate(zip(statements, bodies)):
+            if stmt.comments:
+                if n > 0:
+                    lines.append('')
+                lines.extend(f'{indent}    {c}' for c in stmt.comments)
+            lines.append(f'{indent}    {body}')
+            self.note_vector_calls(body)
+        lines.append(f'{indent}}}')
+        return lines
+
+    def emit_loop(self, statements, indent):
+        """Emit one SIMD loop running every statement's body in order.
+
+        With --stride-versioning, runtime strides get a unit-stride copy of the
+        loop with contiguous accesses; the general loop, which the compiler
+        lowers to gathers and scatters, runs otherwise.
+
+        With --backend vec, statements vec.h can express become vdouble8
+        calls instead of a loop.
+
+        The first line carries no indent because it replaces the node text,
+        which starts after the existing indentation.
+        """
+        if self.backend == 'vec':
+            vector = self.vec_lines(statements, indent)
+            if vector:
+                return vector
+
+        result = [f'{indent}{s.prelude}' for s in statements if s.prelude]
+
+        strides = []
+        if self.stride_versioning:
+            strides = self.runtime_strides(' '.join(s.text for s in statements))
+        if strides:
+            unit = ' && '.join(f'{self.operand(k)} == 1' for k in strides)
+            result.append(f'{indent}if ({unit}) {{')
+            result.extend(self.loop_lines(statements, indent + '    ', strides, nested='    '))
+            result.append(f'{indent}}} else {{')
+            result.extend(self.loop_lines(statements, indent + '    ', nested='    '))
+            result.append(f'{indent}}}')
+            self.versioned_loops += 1
+        else:
+            result.extend(self.loop_lines(statements, indent))
+
+        self.conversions += len(statements)
+        return '\n'.join(result)[len(indent):]
+
+    def is_tileable(self, group):
+        """True if --tile applies to group: several statements over a runtime extent.
+
+        Groups with runtime strides are left to --stride-versioning.
+        """
+        if not self.tile or len(group) < 2 or self.is_constant_extent(group[0].extent):
+            return False
+        return not (self.stride_versioning and self.runtime_strides(' '.join(s.text for s in group)))
+
+    def emit_tiles(self, statements, indent):
+        """Emit a group as a loop over tiles of --tile elements, each running every statement.
+
+        Each statement keeps its own SIMD loop over the tile, so an array one
+        statement writes is still in L1 when the next one reads it. Reduction
+        variables are initialized once before the tile loop and accumulate
+        across tiles. Every statement only touches its own element (can_fuse
+        holds for the group), so running them tile by tile gives the same
+        results as running each over the whole extent.
+        """
+        text = ' '.join(s.text for s in statements)
+        tile = 'tile'
+        while re.search(rf'\b{tile}(?:_end)?\b', text):
+            tile += '_'
+        end = f'{tile}_end'
+        extent = statements[0].extent
+        bound = self.operand(extent)
+
+        result = [f'{indent}{s.prelude}' for s in statements if s.prelude]
+        result += [f'{indent}for (int {tile} = 0; {tile} < {extent}; {tile} += {self.tile}) {{',
+                   f'{indent}    int {end} = {tile} + {self.tile} < {bound} ? {tile} + {self.tile} : {bound};']
+        for n, stmt in enumerate(statements):
+            comments, stmt.comments = stmt.comments, []
+            if comments and n > 0:
+                result.append('')
+            result.extend(f'{indent}    {c}' for c in comments)
+            result.extend(self.loop_lines([stmt], indent + '    ', tile=(tile, end), nested='    '))
+        result.append(f'{indent}}}')
+
+        self.conversions += len(statements)
+        self.tiled_loops += 1
+        return '\n'.join(result)[len(indent):]
+
+    def convert_reduction(self, text, indent):
+        """Convert a __sec_reduce_* call to OpenMP SIMD reduction loops."""
+        stmt = self.reduction_statement(None, text)
+        if stmt and self.is_repro_sum(text):
+            return self.repro_sum_lines(stmt, indent)
+        if stmt:
+            return self.emit_loop([stmt], indent)
+        loops = self.index_reduction_statements(text)
+        if loops:
+            return f'\n{indent}'.join(self.emit_loop(group, indent) for group in loops)
+        return None
 
     def convert_assignment(self, text, indent):
         """Convert Cilk Plus array assignment to OpenMP SIMD loop."""
-        converted = self.replace_vall(text.strip())
-        result = [
-            f'{indent}#pragma omp simd',
-            f'{indent}for (int i = 0; i < {self.length_var}; i++) {{',
-            f'{indent}    {converted}',
-            f'{indent}}}'
-        ]
+        return self.emit_loop([self.assignment_statement(None, text)], indent)
+
+    def branch_assignments(self, source_bytes, branch):
+        """Lower a masked branch to [(lhs, value)], or None if it is not only section assignments."""
+        statements = branch.named_children if branch.type == 'compound_statement' else [branch]
+        assignments = []
+        for stmt in statements:
+            if stmt.type == 'comment':
+                continue
+            text = self.node_text(source_bytes, stmt).strip()
+            match = re.fullmatch(BLEND_ASSIGNMENT, text, re.S)
+            if stmt.type != 'expression_statement' or not match or not self.has_cilk_notation(match.group(1)):
+                return None
+            calls = set(re.findall(r'\b(\w+)\s*\(', match.group(3)))
+            if not calls <= BLEND_SAFE_FUNCTIONS:
+                return None
+            lhs = self.replace_vall(match.group(1))
+            rhs = self.replace_vall(match.group(3))
+            if match.group(2):
+                simple = re.fullmatch(r'[\w.]+(?:\[[^\[\]]*\])?', rhs)
+                rhs = f'{lhs} {match.group(2)} {rhs if simple else f"({rhs})"}'
+            assignments.append((lhs, rhs))
+        return assignments
+
+    def mask_condition(self, source_bytes, node):
+        """Element condition of a masked if, as an int that is 0 or 1."""
+        condition = self.replace_vall(self.node_text(source_bytes, node.child_by_field_name('condition')))
+        condition = condition.strip()[1:-1].strip()
+        if not re.search(r'[<>!=]=|[<>]|&&|\|\||^!', condition):
+            simple = re.fullmatch(r'[\w.]+(?:\[[^\[\]]*\])?', condition)
+            condition = f'{condition if simple else f"({condition})"} != 0'
+        return condition
+
+    def blend_if_statement(self, source_bytes, node):
+        """If-convert a masked if/else into select statements, or None if it has other statements.
+
+        The mask is evaluated once per element; assignments to the same element
+        at the head of both branches merge into one select, the others keep
+        the old value where their branch is not taken.
+        """
+        alternative = node.child_by_field_name('alternative')
+        then_branch = self.branch_assignments(source_bytes, node.child_by_field_name('consequence'))
+        else_branch = []
+        if alternative is not None:
+            else_node = alternative.named_children[-1]
+            else_branch = None if else_node.type == 'if_statement' else \
+                self.branch_assignments(source_bytes, else_node)
+        if then_branch is None or else_branch is None:
+            return None
+
+        text = self.node_text(source_bytes, node)
+        mask = 'mask'
+        while re.search(rf'\b{mask}\b', text):
+            mask += '_'
+        lines = [f'int {mask} = {self.mask_condition(source_bytes, node)};']
+        merged = 0
+        for (lhs, then_value), (else_lhs, else_value) in zip(then_branch, else_branch):
+            if lhs != else_lhs:
+                break
+            lines.append(f'{lhs} = {mask} ? {then_value} : {else_value};')
+            merged += 1
+        lines += [f'{lhs} = {mask} ? {value} : {lhs};' for lhs, value in then_branch[merged:]]
+        lines += [f'{lhs} = {mask} ? {lhs} : {value};' for lhs, value in else_branch[merged:]]
+        return lines
+
+    def pack_statements(self, source_bytes, node):
+        """Lower a masked append to (counter, [(lhs, value)]), or None if node is not a pack.
+
+        A pack stores the selected elements one after another:
+            if (mask[0:n]) { dst[k++] = value; }
+        or, for several destinations, dst[k] = value; ... k++; with no else.
+        """
+        body = node.child_by_field_name('consequence')
+        statements = body.named_children if body.type == 'compound_statement' else [body]
+        statements = [self.node_text(source_bytes, s).strip() for s in statements if s.type != 'comment']
+        if node.child_by_field_name('alternative') is not None or not statements:
+            return None
+        increment = re.fullmatch(PACK_INCREMENT, statements[-1])
+        counter = increment and next(g for g in increment.groups() if g)
+        stores = [re.fullmatch(PACK_STORE, s, re.S) for s in (statements[:-1] if increment else statements)]
+        if not stores or not all(stores):
+            return None
+        if increment:
+            if any(m.group(2) != counter or m.group(3) for m in stores):
+                return None
+        elif len(stores) != 1 or not stores[0].group(3):
+            return None
+        counter = stores[0].group(2)
+        return counter, [(f'{m.group(1)}[{counter}]', self.replace_vall(m.group(4))) for m in stores]
+
+    def is_in_place_pack(self, source_bytes, node, stores):
+        """True if a pack destination is also read by the mask or a stored value."""
+        reads = self.node_text(source_bytes, node.child_by_field_name('condition'))
+        reads += ' '.join(value for _, value in stores)
+        return any(re.search(rf'\b{re.escape(lhs.split("[")[0])}\b', reads) for lhs, _ in stores)
+
+    def convert_pack(self, source_bytes, node, indent, extent):
+        """Lower a masked append to an exclusive-scan loop, or None if node is not a pack.
+
+        The counter becomes an inscan + reduction: each element stores at the
+        count of selected elements before it, then adds its mask, so the loop
+        vectorizes as a prefix sum and a scatter (AVX-512; AVX2 has no
+        scatter and runs it scalar) instead of a branch on a loop-carried
+        counter. Packing in place, or an append the loop cannot express, stays
+        a scalar loop: the order of the stores matters there.
+        """
+        pack = self.pack_statements(source_bytes, node)
+        text = self.node_text(source_bytes, node)
+        line = node.start_point[0] + 1
+        if pack and not self.is_in_place_pack(source_bytes, node, pack[1]):
+            counter, stores = pack
+            condition = self.mask_condition(source_bytes, node)
+            lines = [f'#pragma omp simd reduction(inscan, +:{counter})',
+                     f'for (int i = 0; i < {extent}; i++) {{',
+                     f'    if ({condition}) {{']
+            lines += [f'        {lhs} = {value};' for lhs, value in stores]
+            lines += ['    }',
+                      f'    #pragma omp scan exclusive({counter})',
+                      f'    {counter} += {condition};',
+                      '}']
+            self.note_vector_calls('\n'.join(lines))
+            self.pack_loops += 1
+            self.conversions += 1
+            return '\n'.join(f'{indent}{l}' for l in lines)[len(indent):]
+        if not pack and not re.search(SCALAR_INCREMENT, text):
+            return None
+
+        reason = 'packs in place' if pack else 'updates a counter outside a dst[k++] = value append'
+        self.log(f"WARNING: conditional at line {line} {reason}; kept as a scalar loop")
+        first, *rest = self.replace_vall(text).split('\n')
+        result = [f'{indent}for (int i = 0; i < {extent}; i++) {{', f'{indent}    {first}']
+        result += [f'    {l}' if l.strip() else l for l in rest]
+        result.append(f'{indent}}}')
         self.conversions += 1
-        return '\n'.join(result)
+        return '\n'.join(result)[len(indent):]
 
     def convert_if_statement(self, source_bytes, node, indent):
         """Convert if statement with Cilk Plus notation - wrap entire block in loop."""
         text = source_bytes[node.start_byte:node.end_byte].decode('utf-8', errors='replace')
+        extent = self.section_extent(text)
+
+        packed = self.convert_pack(source_bytes, node, indent, extent)
+        if packed:
+            return packed
+
+        if self.if_convert:
+            lines = self.blend_if_statement(source_bytes, node)
+            line = node.start_point[0] + 1
+            if lines:
+                body = '\n'.join(lines)
+                self.note_vector_calls(body)
+                self.blended_loops += 1
+                self.conversions += 1
+                self.log(f"NOTE: if-converted conditional at line {line} evaluates both branches for "
+                         f"every element; GCC vectorizes it only with -fno-trapping-math "
+                         f"(and -fno-math-errno if a branch calls a math function)")
+                result = [f'{indent}{self.simd_pragma(body, extent)}',
+                          f'{indent}for (int i = 0; i < {extent}; i++) {{']
+                result += [f'{indent}    {l}' for l in lines]
+                result.append(f'{indent}}}')
+                return '\n'.join(result)[len(indent):]
+            self.log(f"WARNING: conditional at line {line} kept as a branch: if-conversion needs "
+                     f"branches of section assignments calling only side-effect-free math functions")
+
         converted = self.replace_vall(text)
+        self.note_vector_calls(converted)
 
         # Indent the entire if block
         lines = converted.split('\n')
@@ -112,24 +1234,390 @@ class TreeSitterCilkConverter:
         indented_block = '\n'.join(indented_lines)
 
         result = [
-            f'{indent}#pragma omp simd',
-            f'{indent}for (int i = 0; i < {self.length_var}; i++) {{',
+            f'{indent}{self.simd_pragma(converted, extent)}',
+            f'{indent}for (int i = 0; i < {extent}; i++) {{',
             f'{indented_block}',
             f'{indent}}}'
         ]
         self.conversions += 1
-        return '\n'.join(result)
+        return '\n'.join(result)[len(indent):]
+
+    def node_text(self, source_bytes, node):
+        return source_bytes[node.start_byte:node.end_byte].decode('utf-8', errors='replace')
+
+    def convert_cilk_for(self, source_bytes, node, indent, replacements):
+        """Replace the cilk_for keyword with an omp parallel for worksharing loop.
+
+        A preceding '#pragma cilk grainsize' becomes the schedule chunk size.
+        """
+        schedule = self.cilk_for_schedule
+        prev = node.prev_sibling
+        if prev is not None and prev.type == 'preproc_call':
+            match = re.fullmatch(GRAINSIZE_PATTERN, self.node_text(source_bytes, prev).strip())
+            if match:
+                schedule += f', {(match.group(1) or match.group(2)).strip()}'
+                line_start = source_bytes.rfind(b'\n', 0, prev.start_byte) + 1
+                replacements.append((line_start, node.start_byte, indent))
+
+        text = self.node_text(source_bytes, node)
+        keyword = re.match(CILK_FOR, text).group(0)
+        pragma = f'#pragma omp parallel for schedule({schedule})' + self.reduction_clauses(text)
+        replacements.append((node.start_byte, node.start_byte + len(keyword), f'{pragma}\n{indent}for'))
+        self.conversions += 1
+
+    def convert_spawn(self, text, indent):
+        """Convert a spawned call statement to an omp task.
+
+        The assigned variable is shared so the result outlives the task; a
+        declaration is split so the variable stays in the enclosing scope.
+        """
+        text = re.sub(CILK_SPAWN + r'\s*', '', text.strip())
+        decl = re.match(r'((?:[\w*]+\s+)+\**)(\w+)\s*=\s*(.+;)$', text)
+        lines = []
+        if decl and not re.match(r'\w+\s*=', text):
+            lines.append(f'{indent}{decl.group(1).rstrip()} {decl.group(2)};')
+            text = f'{decl.group(2)} = {decl.group(3)}'
+        assign = re.match(r'(\w+)\s*(?:\[[^\]]*\]|\.\w+|->\w+)*\s*[-+*/]?=(?!=)', text)
+        pragma = f'#pragma omp task shared({assign.group(1)})' if assign else '#pragma omp task'
+        lines.append(f'{indent}{pragma}')
+        lines.append(f'{indent}{text}')
+        self.conversions += 1
+        return '\n'.join(lines)[len(indent):]
+
+    def implicit_syncs(self, source_bytes, function, replacements):
+        """Add the taskwait that Cilk implies before a spawning function returns.
+
+        Without it, tasks could outlive the frame whose variables they share.
+        """
+        first_spawn = function.start_byte + re.search(CILK_SPAWN, self.node_text(source_bytes, function)).start()
+
+        def no_tasks_pending(node):
+            # Directly after a sync, or before any spawn outside a loop that spawns
+            prev = node.prev_sibling
+            while prev is not None and prev.type == 'comment':
+                prev = prev.prev_sibling
+            if prev is not None and re.fullmatch(CILK_SYNC + r'\s*;', self.node_text(source_bytes, prev).strip()):
+                return True
+            if node.start_byte > first_spawn:
+                return False
+            while node is not function:
+                if node.type in ('for_statement', 'while_statement', 'do_statement') and node.end_byte > first_spawn:
+                    return False
+                node = node.parent
+            return True
+
+        stack = [function]
+        while stack:
+            node = stack.pop()
+            stack.extend(node.children)
+            if node.type != 'return_statement' or no_tasks_pending(node):
+                continue
+            indent = self.get_indent(source_bytes, node)
+            if node.parent.type == 'compound_statement':
+                replacements.append((node.start_byte, node.start_byte, f'#pragma omp taskwait\n{indent}'))
+            else:
+                outer = self.get_indent(source_bytes, node.parent)
+                replacements.append((node.start_byte, node.end_byte,
+                                     f'{{\n{outer}    #pragma omp taskwait\n{outer}    '
+                                     f'{self.node_text(source_bytes, node)}\n{outer}}}'))
+
+        body = function.child_by_field_name('body')
+        statements = [c for c in body.named_children if c.type != 'comment']
+        if statements and statements[-1].type != 'return_statement':
+            closing = body.end_byte - 1
+            last = statements[-1]
+            if not re.fullmatch(CILK_SYNC + r'\s*;', self.node_text(source_bytes, last).strip()):
+                indent = self.get_indent(source_bytes, last)
+                replacements.append((last.end_byte, last.end_byte, f'\n{indent}#pragma omp taskwait'))
+
+    def convert_task_construct(self, source_bytes, node, indent, replacements):
+        """Convert cilk_for/cilk_spawn/cilk_sync at node; False if node is none of them."""
+        text = self.node_text(source_bytes, node)
+        if node.type == 'for_statement' and re.match(CILK_FOR, text):
+            self.convert_cilk_for(source_bytes, node, indent, replacements)
+            for child in node.children:
+                self.process_node(source_bytes, child, replacements)
+            return True
+        if node.type in ('expression_statement', 'declaration') and re.search(CILK_SPAWN, text):
+            replacements.append((node.start_byte, node.end_byte, self.convert_spawn(text, indent)))
+            return True
+        if node.type == 'expression_statement' and re.fullmatch(CILK_SYNC + r'\s*;', text.strip()):
+            replacements.append((node.start_byte, node.end_byte, '#pragma omp taskwait'))
+            self.conversions += 1
+            return True
+        if node.type == 'function_definition' and re.search(CILK_SPAWN, text):
+            self.implicit_syncs(source_bytes, node, replacements)
+            self.log(f"WARNING: cilk_spawn in function at line {node.start_point[0] + 1} became omp task; "
+                     f"call it inside '#pragma omp parallel' + '#pragma omp single' for tasks to run in parallel")
+            for name in self.reducers:
+                if re.search(rf'\b{name}\b', text):
+                    self.log(f"WARNING: reducer '{name}' used in spawning function at line "
+                             f"{node.start_point[0] + 1} became a shared variable; updates from "
+                             f"tasks need '#pragma omp atomic' or per-task results")
+        return False
+
+    def find_reducers(self, text):
+        """Collect the reducer declarations in text, keyed by variable name."""
+        reducers = {}
+        for match in re.finditer(C_REDUCER, text):
+            kind, name, type_name, init = match.groups()
+            ctype = C_REDUCER_TYPES.get(type_name, type_name)
+            reducers[name] = Reducer(name, REDUCER_OPS[kind.lower()], ctype, init, match.group(0))
+        for match in re.finditer(CPP_REDUCER, text):
+            kind = match.group(1) or match.group(3)
+            ctype = match.group(2) or match.group(4)
+            name, init = match.group(5), match.group(6)
+            op = REDUCER_OPS[kind]
+            if not init:
+                init = REDUCER_IDENTITY.get(op)
+                if init is None:
+                    self.log(f"WARNING: reducer '{name}' ({kind}) has no initial value; left unconverted")
+                    continue
+            reducers[name] = Reducer(name, op, ctype, init, match.group(0))
+        for match in re.finditer(CUSTOM_C_REDUCER, text):
+            ctype, name, reduce_fn, identity_fn, destroy_fn, init = match.groups()
+            op = f'{name}_reduce'
+            combiner = (f'#pragma omp declare reduction({op} : {ctype} : '
+                        f'{reduce_fn}(NULL, &omp_out, &omp_in)) '
+                        f'initializer({identity_fn}(NULL, &omp_priv))')
+            reducers[name] = Reducer(name, op, ctype, init, match.group(0), combiner, destroy_fn)
+        if re.search(r'\bcilk::reducer\s*<', text) and not re.search(r'\bcilk::reducer\s*<\s*cilk::op_', text):
+            self.log("WARNING: cilk::reducer<Monoid> with a custom monoid is not converted; "
+                     "write a '#pragma omp declare reduction' from its reduce() and identity()")
+        return reducers
+
+    def reduction_clauses(self, text):
+        """Return the reduction clauses for the reducers referenced in a cilk_for."""
+        used = [r for name, r in self.reducers.items() if re.search(rf'\b{name}\b', text)]
+        clauses = ''
+        for op in dict.fromkeys(r.op for r in used):
+            clauses += f' reduction({op}:{",".join(r.name for r in used if r.op == op)})'
+        return clauses
+
+    def lower_reducers(self, text):
+        """Replace reducer declarations, registration and view accesses with plain variables."""
+        text = re.sub(r'^[ \t]*#\s*include\s*<cilk/[^>]+>[ \t]*\n', '', text, flags=re.M)
+        text = re.sub(r'^[ \t]*CILK_C_(?:UN)?REGISTER_REDUCER\s*\(\s*\w+\s*\)\s*;[ \t]*\n', '',
+                      text, flags=re.M)
+        for r in self.reducers.values():
+            line_start = text.rfind('\n', 0, text.find(r.declaration)) + 1
+            indent = re.match(r'[ \t]*', text[line_start:]).group(0)
+            declaration = f'{r.ctype} {r.name} = {r.init};'
+            if r.combiner:
+                declaration = f'{r.combiner}\n{indent}{declaration}'
+            if r.destroy:
+                # Keeps -Wunused-function quiet for the callback the reducer no longer calls
+                declaration += f'\n{indent}(void){r.destroy};  // OpenMP private copies need no destroy'
+            text = text.replace(r.declaration, declaration, 1)
+
+            name = re.escape(r.name)
+            text = re.sub(rf'\bREDUCER_VIEW\s*\(\s*{name}\s*\)', r.name, text)
+            text = re.sub(rf'\b{name}\s*\.\s*(?:value\b|get_value\s*\(\s*\))', r.name, text)
+            text = re.sub(rf'\b{name}\s*\.\s*set_value\s*\(\s*([^;]*?)\s*\)\s*;', rf'{r.name} = \1;', text)
+            # C++ view dereference: '*' not following an operand, so not a multiplication
+            text = re.sub(rf'((?:^|[^\w)\]\s]|\breturn)\s*)\*\s*{name}\b', rf'\1{r.name}', text, flags=re.M)
+            if r.op in ('max', 'min'):
+                cmp = '>' if r.op == 'max' else '<'
+                update = rf'{r.name} = (\1) {cmp} {r.name} ? (\1) : {r.name};'
+                text = re.sub(rf'\bCILK_C_REDUCER_{r.op.upper()}_CALC\s*\(\s*{name}\s*,\s*\w+\s*,'
+                              rf'\s*([^;]*?)\s*\)\s*;', update, text)
+                text = re.sub(rf'\b{name}\s*\.\s*calc_{r.op}\s*\(\s*([^;]*?)\s*\)\s*;', update, text)
+            self.conversions += 1
+        return text
+
+    def section_statement(self, source_bytes, node):
+        """Return a fusable SectionStatement for node, or None."""
+        if node.type not in ('declaration', 'expression_statement'):
+            return None
+        text = source_bytes[node.start_byte:node.end_byte].decode('utf-8', errors='replace')
+        if not self.has_cilk_notation(text) or self.section_extent(text) is None:
+            return None
+        if self.is_reduction(text):
+            if self.is_repro_sum(text):
+                return None  # keeps its own fixed-order loops
+            return self.reduction_statement(node, text)  # None for *_ind, kept unfused
+        if node.type == 'expression_statement' and '=' in text:
+            return self.assignment_statement(node, text)
+        return None
+
+    def written_arrays(self, stmt):
+        """Arrays stmt stores to through a section, mapped to the element index written."""
+        match = re.match(r'(\w+)\s*' + SECTION_PATTERN + r'\s*[-+*/]?=(?!=)', stmt.text.strip())
+        return {match.group(1): self.section_index(match.group(2))} if match else {}
+
+    def can_fuse(self, group, stmt):
+        """Check that stmt can join the loop of group without changing results.
+
+        Every iteration only touches one element of a written array, so fusion
+        is legal as long as written arrays are never accessed other than through
+        a section with the same start and stride, and no statement reads a
+        reduction result before it is complete.
+        """
+        if stmt.extent != group[0].extent:
+            return False
+        members = group + [stmt]
+        written = {}
+        for s in members:
+            for name, index in self.written_arrays(s).items():
+                if written.setdefault(name, index) != index:
+                    return False
+        for name, index in written.items():
+            for s in members:
+                # max/min initializers read element 0 before the loop runs
+                if s.prelude and re.search(rf'\b{re.escape(name)}\b', s.prelude):
+                    return False
+                for ref in re.finditer(rf'\b{re.escape(name)}\b\s*(\[[^\]]*\])?', s.text):
+                    section = ref.group(1) and re.fullmatch(SECTION_PATTERN, ref.group(1))
+                    if not section or self.section_index(section.group(1)) != index:
+                        return False
+        reduced = {s.reduction[1] for s in members if s.reduction}
+        for name in reduced:
+            for s in members:
+                uses = re.findall(rf'\b{re.escape(name)}\b', s.text)
+                if len(uses) > (1 if s.reduction and s.reduction[1] == name else 0):
+                    return False
+        return True
+
+    def identifier_uses(self, source_bytes, node, name):
+        """Start offsets of the word name under node, outside comments."""
+        text = bytearray(source_bytes[node.start_byte:node.end_byte])
+        stack = [node]
+        while stack:
+            child = stack.pop()
+            stack.extend(child.children)
+            if child.type == 'comment':
+                start, end = child.start_byte - node.start_byte, child.end_byte - node.start_byte
+                text[start:end] = b' ' * (end - start)
+        pattern = rf'\b{re.escape(name)}\b'.encode()
+        return [node.start_byte + m.start() for m in re.finditer(pattern, bytes(text))]
+
+    def replace_temporaries(self, source_bytes, group, replacements):
+        """Keep local arrays that only this fused group uses in scalars (--scalar-replace).
+
+        An array qualifies when it is a plain local array of the current
+        function, a statement of the group assigns it with '=' without reading
+        it, and every other use of it in the function comes later in the
+        group. Each iteration then writes its element before reading it and
+        nothing reads it afterwards, so the loop can declare a scalar of the
+        same name instead; the array declaration is removed.
+        """
+        if self.function is None:
+            return
+        declarations = {}
+        stack = [self.function]
+        while stack:
+            node = stack.pop()
+            stack.extend(node.children)
+            match = node.type == 'declaration' and re.fullmatch(
+                TEMPORARY_ARRAY_PATTERN, self.node_text(source_bytes, node).strip())
+            if match:
+                declarations[match.group(2)] = (node, match.group(1))
+
+        for n, stmt in enumerate(group):
+            for name, index in self.written_arrays(stmt).items():
+                if name not in declarations:
+                    continue
+                declaration, ctype = declarations[name]
+                assignment = re.match(rf'\s*{re.escape(name)}\s*{SECTION_PATTERN}\s*=(?!=)', stmt.text)
+                inside = lambda offset, s: s.node.start_byte <= offset < s.node.end_byte
+                uses = self.identifier_uses(source_bytes, self.function, name)
+                if (not assignment or sum(inside(u, stmt) for u in uses) != 1 or
+                        not all(declaration.start_byte <= u < declaration.end_byte or
+                                any(inside(u, s) for s in group[n:]) for u in uses)):
+                    continue
+                element = rf'\b{re.escape(name)}\[{re.escape(index)}\]'
+                stmt.body = re.sub(rf'^{element}\s*=', f'{ctype} {name} =', stmt.body)
+                for later in group[n + 1:]:
+                    later.body = re.sub(element, name, later.body)
+                self.remove_declaration(source_bytes, declaration, replacements)
+                self.aligned_arrays.discard(name)
+                self.scalar_temporaries.append(name)
+
+    def remove_declaration(self, source_bytes, node, replacements):
+        """Delete a declaration, with its line if it is alone on it, and edits inside it."""
+        start, end = node.start_byte, node.end_byte
+        line_start = source_bytes.rfind(b'\n', 0, start) + 1
+        if not source_bytes[line_start:start].strip() and source_bytes[end:end + 1] == b'\n':
+            start, end = line_start, end + 1
+        replacements[:] = [r for r in replacements if not (start <= r[0] and r[1] <= end)]
+        replacements.append((start, end, ''))
+
+    def fuse_block(self, source_bytes, node, replacements):
+        """Fuse runs of adjacent section statements among the children of node."""
+        group = []
+        pending_comments = []
+
+        def flush():
+            if not group:
+                return
+            first, last = group[0].node, group[-1].node
+            indent = self.get_indent(source_bytes, first)
+            if self.is_tileable(group):
+                replacements.append((first.start_byte, last.end_byte, self.emit_tiles(group, indent)))
+            elif not self.fuse:
+                # --tile without --fuse: untiled statements keep their own loops
+                for stmt in group:
+                    self.process_node(source_bytes, stmt.node, replacements)
+            else:
+                if self.scalar_replace and self.backend == 'omp' and len(group) > 1:
+                    self.replace_temporaries(source_bytes, group, replacements)
+                replacements.append((first.start_byte, last.end_byte, self.emit_loop(group, indent)))
+                if len(group) > 1:
+                    self.fused_loops += 1
+
+        for child in node.children:
+            if child.type == 'comment' and group:
+                pending_comments.append(child)
+                continue
+            stmt = self.section_statement(source_bytes, child)
+            if stmt and group and self.can_fuse(group, stmt):
+                stmt.comments = [
+                    source_bytes[c.start_byte:c.end_byte].decode('utf-8', errors='replace')
+                    for c in pending_comments
+                ]
+                group.append(stmt)
+                pending_comments = []
+                continue
+            flush()
+            group = [stmt] if stmt else []
+            pending_comments = []
+            if not stmt:
+                self.process_node(source_bytes, child, replacements)
+        flush()
 
     def process_node(self, source_bytes, node, replacements):
         """Recursively process AST nodes, collecting replacements."""
         text = source_bytes[node.start_byte:node.end_byte].decode('utf-8', errors='replace')
 
         # Check if this node contains Cilk Plus notation
-        if not self.has_cilk_notation(text):
+        notation = self.has_cilk_notation(text)
+        if not notation and not self.has_cilk_keywords(text):
             return
 
         indent = self.get_indent(source_bytes, node)
 
+        # A statement over sections of different lengths has no one trip count
+        if (notation and node.type in ('declaration', 'expression_statement', 'if_statement')
+                and self.section_extent(text) is None):
+            first, second = self.section_extents(text)[:2]
+            self.log(f"WARNING: sections at line {node.start_point[0] + 1} have different lengths "
+                     f"({first}, {second}); left unconverted")
+            return
+
+        if self.convert_task_construct(source_bytes, node, indent, replacements):
+            return
+
+        # VLA temporaries of this block, allocated from the arena once it is converted
+        arena_arrays = []
+        if self.arena and node.type == 'compound_statement':
+            arena_arrays = self.variable_arrays(source_bytes, node)
+
+        # In fusion and tiling mode, statement lists are converted as groups
+        if (self.fuse or self.tile) and node.type in ('compound_statement', 'translation_unit'):
+            self.fuse_block(source_bytes, node, replacements)
+            self.allocate_from_arena(source_bytes, node, arena_arrays, replacements)
+            return
+
         # Handle declarations with reductions (int x = __sec_reduce_add(...))
         if node.type == 'declaration' and self.is_reduction(text):
             converted = self.convert_reduction(text, indent)
@@ -138,7 +1626,7 @@ class TreeSitterCilkConverter:
                 return
 
         # Handle expression statements (assignments and reductions)
-        if node.type == 'expression_statement':
+        if node.type == 'expression_statement' and notation:
             if self.is_reduction(text):
                 converted = self.convert_reduction(text, indent)
                 if converted:
@@ -151,55 +1639,337 @@ class TreeSitterCilkConverter:
                     return
 
         # Handle if statements - wrap entire block
-        if node.type == 'if_statement':
+        if node.type == 'if_statement' and notation:
             converted = self.convert_if_statement(source_bytes, node, indent)
             if converted:
                 replacements.append((node.start_byte, node.end_byte, converted))
                 return
 
+        # Local arrays are aligned per function, for the aligned clause
+        if node.type == 'function_definition' and self.simd_clauses:
+            self.aligned_arrays = self.align_local_arrays(source_bytes, node, replacements)
+        if node.type == 'function_definition':
+            self.function = node
+            self.double_arrays = self.global_arrays | self.array_names(text)
+            if self.dispatch and notation:
+                self.dispatch_function(source_bytes, node, replacements)
+
         # Recurse into children
         for child in node.children:
             self.process_node(source_bytes, child, replacements)
+        self.allocate_from_arena(source_bytes, node, arena_arrays, replacements)
+
+        if node.type == 'function_definition':
+            self.function = None
+            self.aligned_arrays = set()
+            self.double_arrays = self.global_arrays
+
+    def apply_replacements(self, source_bytes, replacements):
+        """Apply (start, end, text) replacements in one forward pass.
+
+        Returns the result and, for every output line, (first, last, generated):
+        the source lines it came from and whether converted text is on it.
+        Insertions at the same offset come out last appended first.
+        """
+        pieces = []
+        origins = [(1, 1, False)]
+        pos, line = 0, 1
+        for k in sorted(range(len(replacements)), key=lambda k: (replacements[k][0], -k)):
+            start, end, text = replacements[k]
+            for _ in range(source_bytes.count(b'\n', pos, start)):
+                line += 1
+                origins.append((line, line, False))
+            last = line + source_bytes.count(b'\n', start, end)
+            origins[-1] = (origins[-1][0], last, True)
+            new = text.encode('utf-8')
+            origins.extend([(line, last, True)] * new.count(b'\n'))
+            pieces += [source_bytes[pos:start], new]
+            pos, line = end, last
+        for _ in range(source_bytes.count(b'\n', pos)):
+            line += 1
+            origins.append((line, line, False))
+        pieces.append(source_bytes[pos:])
+        return b''.join(pieces), origins
+
+    def remap_origins(self, before, after, origins):
+        """Carry line origins across a text rewrite by matching its unchanged lines."""
+        old, new = before.split('\n'), after.split('\n')
+        mapped = []
+        for tag, i1, i2, j1, j2 in difflib.SequenceMatcher(None, old, new, autojunk=False).get_opcodes():
+            if tag == 'equal':
+                mapped += origins[i1:i2]
+            else:
+                first, last, _ = origins[min(i1, len(origins) - 1)]
+                mapped += [(first, last, True)] * (j2 - j1)
+        return mapped
+
+    def generated_loops(self, text):
+        """(first, last) output lines and source origin of every converted SIMD loop."""
+        lines = text.split('\n')
+        loops = []
+        for n, line in enumerate(lines):
+            if not self.line_origins[n][2] or \
+                    not re.match(r'\s*#\s*pragma\s+omp\s+(?:parallel\s+for\s+)?simd\b', line):
+                continue
+            depth = 0
+            for end in range(n + 1, len(lines)):
+                depth += lines[end].count('{') - lines[end].count('}')
+                if depth <= 0 and '}' in lines[end]:
+                    break
+            loops.append((n + 1, end + 1, self.line_origins[n][:2]))
+        return loops
+
+    def vectorization_remarks(self, output_path, include_dir, cc, cflags):
+        """Compile output_path and collect {line: [(vectorized, message)]} vectorizer remarks.
+
+        Returns (remarks, None), or (None, error) if the compiler failed.
+        """
+        clang = 'clang' in Path(cc).name
+        remark_flags = (['-Rpass=loop-vectorize', '-Rpass-missed=loop-vectorize',
+                         '-Rpass-analysis=loop-vectorize'] if clang else ['-fopt-info-vec-all'])
+        cmd = [cc, '-fopenmp-simd', *shlex.split(cflags), f'-I{include_dir}', *remark_flags,
+               '-c', str(output_path), '-o', os.devnull]
+        try:
+            proc = subprocess.run(cmd, capture_output=True, text=True)
+        except OSError as e:
+            return None, f'{cc}: {e.strerror}'
+        if proc.returncode != 0:
+            errors = [l for l in proc.stderr.splitlines() if 'error' in l]
+            return None, ' | '.join(errors[:3]) or f'{cc} exited with status {proc.returncode}'
+
+        target = Path(output_path).resolve()
+        remarks = {}
+        for line in proc.stderr.splitlines():
+            match = re.match(CLANG_REMARK if clang else GCC_REMARK, line)
+            if not match or Path(match.group(1)).resolve() != target:
+                continue
+            if clang:
+                vectorized, message = match.group(4) is None, match.group(3)
+            else:
+                vectorized, message = match.group(3) == 'optimized', match.group(4)
+                if vectorized and 'loop vectorized' not in message:
+                    continue  # basic-block (SLP) remarks say nothing about the loop
+            remarks.setdefault(int(match.group(2)), []).append((vectorized, message))
+        return remarks, None
+
+    def verify_vectorization(self, output_path, include_dir, cc, cflags):
+        """Log every converted SIMD loop the compiler did not vectorize.
+
+        Remarks are attributed to a loop when they fall between its pragma and
+        closing brace; GCC places them on the for line, the body or the brace.
+        Returns the number of loops missed, or None if the output did not compile.
+        """
+        remarks, error = self.vectorization_remarks(output_path, include_dir, cc, cflags)
+        if remarks is None:
+            self.log(f"WARNING: vectorization check could not compile {output_path}: {error}")
+            return None
+
+        with open(output_path, encoding='utf-8') as f:
+            loops = self.generated_loops(f.read())
+        missed = 0
+        for first, last, (src_first, src_last) in loops:
+            found = [r for n in range(first, last + 1) for r in remarks.get(n, [])]
+            where = f'line {src_first}' if src_first == src_last else f'lines {src_first}-{src_last}'
+            if any(vectorized for vectorized, _ in found):
+                self.vectorized_loops += 1
+            elif not found:
+                self.unverified_loops += 1
+                self.log(f"NOTE: no vectorizer remark for the SIMD loop of {where} "
+                         f"(output line {first}); it may have been unrolled or removed")
+            else:
+                reasons = list(dict.fromkeys(m for _, m in found if m != "couldn't vectorize loop"))
+                self.log(f"MISSED: SIMD loop of {where} (output line {first}) not vectorized by {cc}: "
+                         f"{'; '.join(reasons) or 'no reason given'}")
+                missed += 1
+        return missed
 
     def convert_file(self, input_path, output_path):
         """Convert a C file using tree-sitter parsing."""
         with open(input_path, 'rb') as f:
             source_bytes = f.read()
 
-        tree = parser.parse(source_bytes)
+        tree = parser.parse(self.mask_cilk_syntax(source_bytes))
         replacements = []
+        self.reducers = self.find_reducers(source_bytes.decode('utf-8'))
+        self.global_arrays = self.array_names(' '.join(
+            self.node_text(source_bytes, n) for n in tree.root_node.children if n.type == 'declaration'))
+        self.double_arrays = self.global_arrays
 
         self.process_node(source_bytes, tree.root_node, replacements)
 
-        # Sort replacements by position (reverse order for safe replacement)
-        replacements.sort(key=lambda x: x[0], reverse=True)
+        if self.vecmath in VECMATH_LINK and self.vector_calls:
+            replacements.append(self.vecmath_prelude(source_bytes, tree))
+        if self.vec_statements:
+            replacements.append(self.vec_prelude(source_bytes, tree))
+        if self.repro_sums:
+            replacements.append(self.reprosum_prelude(source_bytes, tree))
+        if self.arena_temporaries:
+            replacements.append(self.arena_prelude(source_bytes, tree))
+        if self.unrolled_loops:
+            replacements.append(self.unroll_prelude(source_bytes, tree))
+        if self.dispatched_functions:
+            replacements.append(self.dispatch_prelude(source_bytes, tree))
+            if self.vec_statements:
+                self.log("WARNING: vec.h selects intrinsics from the compile-time target, so the "
+                         "DISPATCH_CLONES clones of vec.h code all run its baseline backend")
 
-        # Apply replacements
-        result = source_bytes
-        for start, end, new_text in replacements:
-            result = result[:start] + new_text.encode('utf-8') + result[end:]
+        result, self.line_origins = self.apply_replacements(source_bytes, replacements)
+        if re.search(rb'__sec_implicit_index\s*\(', result):
+            self.log("WARNING: __sec_implicit_index is only converted for rank 0 of a section statement")
 
-        with open(output_path, 'wb') as f:
-            f.write(result)
+        if self.reducers:
+            text = result.decode('utf-8')
+            lowered = self.lower_reducers(text)
+            self.line_origins = self.remap_origins(text, lowered, self.line_origins)
+            result = lowered.encode('utf-8')
+
+        write_if_changed(output_path, result)
 
         return self.conversions
 
 
+def convert_job(options, verify, input_path, output_path):
+    """Convert one file in batch mode; returns (constructs, warnings, failed)."""
+    converter = TreeSitterCilkConverter(**options)
+    count = converter.convert_file(input_path, output_path)
+    failed = False
+    if verify:
+        cc, cflags, _ = verify
+        missed = converter.verify_vectorization(output_path, Path(input_path).parent, cc, cflags)
+        failed = missed != 0
+    return count, converter.warnings, failed
+
+
+def compiler_identity(cc):
+    """First line of '<cc> --version', so a compiler upgrade invalidates cached checks."""
+    try:
+        proc = subprocess.run([cc, '--version'], capture_output=True, text=True)
+        return proc.stdout.split('\n', 1)[0]
+    except OSError:
+        return cc
+
+
 def main():
     parser_arg = argparse.ArgumentParser(description='Cilk Plus to OpenMP SIMD (tree-sitter)')
-    parser_arg.add_argument('input', help='Input C file')
-    parser_arg.add_argument('output', help='Output C file')
+    parser_arg.add_argument('input', nargs='+',
+                            help='Input C file; several files or directories convert in batch mode')
+    parser_arg.add_argument('output', help='Output C file, or the output directory in batch mode')
     parser_arg.add_argument('--log', default='cilk_convert_ts.log', help='Log file')
+    parser_arg.add_argument('--fuse', action='store_true',
+                            help='Fuse adjacent independent statements into one loop')
+    parser_arg.add_argument('--vecmath', choices=['none', 'libmvec', 'sleef', 'svml'], default='none',
+                            help='Vector math backend for log/exp/pow/sin/cos in converted loops')
+    parser_arg.add_argument('--simd-clauses', action='store_true',
+                            help='Emit simdlen/safelen/aligned clauses and align local arrays')
+    parser_arg.add_argument('--parallel-threshold', type=int, metavar='N',
+                            help='Emit parallel for simd for runtime extents, threaded when >= N')
+    parser_arg.add_argument('--stride-versioning', action='store_true',
+                            help='Add a contiguous unit-stride loop for sections with runtime strides')
+    parser_arg.add_argument('--if-convert', action='store_true',
+                            help='Lower masked if/else blocks to branchless selects')
+    parser_arg.add_argument('--backend', choices=['omp', 'vec'], default='omp',
+                            help='Emit omp simd loops, or src/vec.h vdouble8 calls for VLENGTH sections')
+    parser_arg.add_argument('--dispatch', action='store_true',
+                            help='Build converted functions as AVX-512F/AVX2/default clones picked at startup')
+    parser_arg.add_argument('--repro-sum', action='store_true',
+                            help='Sum doubles in a fixed lane order, bit-identical at any vector width')
+    parser_arg.add_argument('--tile', type=int, metavar='N',
+                            help='Run groups of statements over runtime extents tile by tile, N elements each')
+    parser_arg.add_argument('--scalar-replace', action='store_true',
+                            help='With --fuse, keep local arrays used only inside one fused loop in scalars')
+    parser_arg.add_argument('--arena', action='store_true',
+                            help='Allocate VLA section temporaries from the src/arena.h bump allocator')
+    parser_arg.add_argument('--unroll-constant', action='store_true',
+                            help='Unroll loops over compile-time extents that call scalar functions; '
+                                 'give the rest an exact simdlen')
+    parser_arg.add_argument('--verify-vectorization', action='store_true',
+                            help='Compile the output with $CC and fail if a converted loop did not vectorize')
+    parser_arg.add_argument('--verify-cflags', default='-O2',
+                            help='Compiler flags for --verify-vectorization (default: -O2)')
+    parser_arg.add_argument('--cilk-for-schedule', choices=['dynamic', 'guided'], default='dynamic',
+                            help='OpenMP schedule for converted cilk_for loops')
+    parser_arg.add_argument('--jobs', '-j', type=int, metavar='N',
+                            help='Worker processes in batch mode (default: CPU count)')
+    parser_arg.add_argument('--cache', metavar='DIR',
+                            help='Reuse batch results for unchanged files, keyed by content hash')
 
     args = parser_arg.parse_args()
+    if args.tile is not None and args.tile <= 0:
+        parser_arg.error('--tile must be a positive number of elements')
+    if args.scalar_replace and not args.fuse:
+        parser_arg.error('--scalar-replace works on fused loops and needs --fuse')
+
+    options = dict(fuse=args.fuse, vecmath=args.vecmath, simd_clauses=args.simd_clauses,
+                   parallel_threshold=args.parallel_threshold, cilk_for_schedule=args.cilk_for_schedule,
+                   stride_versioning=args.stride_versioning, if_convert=args.if_convert,
+                   backend=args.backend, dispatch=args.dispatch, repro_sum=args.repro_sum, tile=args.tile,
+                   scalar_replace=args.scalar_replace, arena=args.arena,
+                   unroll_constant=args.unroll_constant)
+    cc = os.environ.get('CC', 'gcc')
+
+    if len(args.input) > 1 or Path(args.input[0]).is_dir():
+        verify = (cc, args.verify_cflags, compiler_identity(cc)) if args.verify_vectorization else None
+        batch = BatchConverter(partial(convert_job, options, verify), __file__,
+                               dict(options, verify=verify), jobs=args.jobs, cache_dir=args.cache)
+        batch.run(args.input, args.output)
+        batch.write_log(args.log)
+        print(batch.summary())
+        if batch.warnings:
+            print(f"Warnings: {len(batch.warnings)} (see {args.log})")
+        if batch.failed:
+            reason = 'did not vectorize or convert' if verify else 'failed to convert'
+            print(f"{len(batch.failed)} files {reason}: {', '.join(batch.failed)}")
+            sys.exit(1)
+        return
 
-    converter = TreeSitterCilkConverter(log_file=args.log)
-    count = converter.convert_file(args.input, args.output)
+    converter = TreeSitterCilkConverter(log_file=args.log, **options)
+    count = converter.convert_file(args.input[0], args.output)
+    missed = None
+    if args.verify_vectorization:
+        missed = converter.verify_vectorization(args.output, Path(args.input[0]).parent, cc, args.verify_cflags)
     converter.write_log()
 
     print(f"Converted {count} Cilk Plus constructs")
+    if args.fuse:
+        print(f"Fused into {converter.fused_loops} multi-statement loops")
+    if args.if_convert:
+        print(f"If-converted conditionals: {converter.blended_loops}")
+    if args.backend == 'vec':
+        print(f"Vector backend (src/vec.h): {converter.vec_statements} statements, "
+              f"{converter.vec_fallbacks} kept as omp simd loops")
+    if args.scalar_replace:
+        print(f"Scalar-replaced temporaries: {', '.join(converter.scalar_temporaries) or 'none'}")
+    if args.arena:
+        print(f"Arena temporaries (src/arena.h): {', '.join(converter.arena_temporaries) or 'none'}")
+    if args.unroll_constant:
+        print(f"Unrolled loops (src/unroll.h): {converter.unrolled_loops}")
+    if args.tile:
+        print(f"Tiled groups ({args.tile} elements per tile): {converter.tiled_loops}")
+    if converter.pack_loops:
+        print(f"Pack loops (exclusive scan): {converter.pack_loops}")
+    if args.repro_sum:
+        print(f"Reproducible sums: {converter.repro_sums}")
+    if args.dispatch:
+        print(f"Multiversioned functions: {', '.join(converter.dispatched_functions) or 'none'}")
+    if args.stride_versioning:
+        print(f"Stride-versioned loops: {converter.versioned_loops}")
+    if args.parallel_threshold:
+        print(f"Parallel loops: {converter.parallel_loops} (threaded for extent >= {args.parallel_threshold})")
+    if args.vecmath in VECMATH_LINK and converter.vector_calls:
+        print(f"Vector math ({args.vecmath}): {', '.join(sorted(converter.vector_calls))}; "
+              f"link with {VECMATH_LINK[args.vecmath]} -lm")
+    elif args.vecmath == 'svml':
+        print("Vector math (svml): build with icx -fimf-use-svml or gcc -mveclibabi=svml -ffast-math")
     if converter.warnings:
         print(f"Warnings: {len(converter.warnings)} (see {args.log})")
+    if args.verify_vectorization:
+        if missed is None:
+            print(f"Vectorization check failed: output does not compile (see {args.log})")
+            sys.exit(1)
+        print(f"Vectorized loops ({cc} {args.verify_cflags}): {converter.vectorized_loops}, "
+              f"missed: {missed}, without remarks: {converter.unverified_loops}")
+        if missed:
+            sys.exit(1)
 
 
 if __name__ == '__main__':
@@ -1,53 +1,527 @@
 #!/usr/bin/env python3
-"""Compare Cilk Plus and OpenMP SIMD outputs with tolerance."""
+"""Compare Cilk Plus and OpenMP SIMD outputs with tolerance.
 
+Both files are streamed in lockstep, so memory stays flat however many
+elements they hold: a key is buffered only while it has been read from one
+side and not yet from the other, which for outputs printed in the same order
+is at most one entry. Only running statistics are kept (max absolute and
+relative error, the ULP histogram and the worst entries).
+
+Inputs are either KEY=value text or binary dumps (src/dump.h): a DUMP_MAGIC
+header followed by records of a 64-byte header (NUL-padded name, numpy dtype
+string such as "<f8" or "<i8", little-endian uint64 length) and the raw
+little-endian elements. Element i of record NAME is compared as key NAME[i],
+exactly as if it had been printed. When numpy is installed, two dumps are
+memory-mapped and same-named records compared in place; with --quiet, whole
+records are checked with array operations and only mismatches are formatted.
+
+With --ulp, also reports the distance in units in the last place for every
+floating-point value, plus a histogram and the worst key. Use it to measure
+what a vector math backend or other fast-math option changes relative to the
+Cilk reference.
+
+Floating-point values must be within DEFAULT_TOLERANCE of the reference
+unless --budgets names a TOML file of per-key error budgets:
+
+    [default]                     # keys no budget matches; abs = 1e-12 if absent
+    abs = 1e-12
+
+    [[budget]]
+    keys = ["SWEEP_SUM[*]", "REDUCTION_SUM*"]   # '*' matches any text
+    rel = 1e-13
+
+    [[budget]]
+    keys = ["OUTPUT[*]"]
+    ulp = 4
+
+A key uses the first budget listed that matches it and passes when its error
+is within any of the bounds given (abs, rel, ulp). Each budget's observed
+maximum errors are reported, so the accuracy cost of an option is measured
+rather than guessed.
+
+Usage:
+    python compare_outputs.py cilk_output.txt openmp_output.txt [--ulp]
+        [--quiet] [--fail-fast] [--worst N] [--budgets FILE]
+"""
+
+import os
+import re
 import sys
+import math
+import heapq
+import struct
+import tomllib
+import argparse
+from array import array
+
+try:
+    import numpy as np
+except ImportError:  # dumps are then read CHUNK elements at a time
+    np = None
+
+# Benchmark results are expected to differ between runs
+TIMING_PREFIXES = ('TIMING_', 'BENCH_', 'PERF_')
+
+DEFAULT_TOLERANCE = 1e-12
 
-def parse_output(filename):
-    result = {}
-    with open(filename) as f:
+# Upper bounds of the ULP histogram buckets; the last bucket is open-ended
+ULP_BUCKETS = (0, 1, 3, 15)
+
+DUMP_MAGIC = b'SIMDDUMP'
+DUMP_RECORD = struct.Struct('<48s8sQ')
+DUMP_TYPES = {'<f8': 'd', '<i8': 'q'}
+
+# Elements read per binary chunk
+CHUNK = 1 << 16
+
+def read_text(filename):
+    """(key, value) pairs of a KEY=value file; values are floats where they parse."""
+    with open(filename, buffering=1 << 20) as f:
         for line in f:
             if '=' in line:
                 key, val = line.strip().split('=', 1)
                 try:
-                    result[key] = float(val)
+                    yield key, float(val)
                 except ValueError:
-                    result[key] = val
-    return result
+                    yield key, val
 
-def main():
-    if len(sys.argv) != 3:
-        print(f"Usage: {sys.argv[0]} <cilk_output> <openmp_output>")
-        sys.exit(1)
+def record_header(f, filename):
+    """(name, dtype, length) of the next dump record, or None at the end of the file."""
+    header = f.read(DUMP_RECORD.size)
+    if not header:
+        return None
+    if len(header) < DUMP_RECORD.size:
+        raise ValueError(f"{filename}: truncated record header")
+    name, dtype, length = DUMP_RECORD.unpack(header)
+    name = name.rstrip(b'\0').decode()
+    dtype = dtype.rstrip(b'\0').decode()
+    if dtype not in DUMP_TYPES:
+        raise ValueError(f"{filename}: {name} has unsupported dtype {dtype}")
+    return name, dtype, length
+
+def read_dump(filename):
+    """(NAME[i], value) pairs of a binary dump, read CHUNK elements at a time."""
+    with open(filename, 'rb') as f:
+        f.read(len(DUMP_MAGIC))
+        while header := record_header(f, filename):
+            name, dtype, length = header
+            index = 0
+            while index < length:
+                chunk = array(DUMP_TYPES[dtype])
+                count = min(CHUNK, length - index)
+                try:
+                    chunk.fromfile(f, count)
+                except EOFError:
+                    raise ValueError(f"{filename}: {name} truncated at element {index}")
+                if sys.byteorder != 'little':
+                    chunk.byteswap()
+                for value in chunk:
+                    yield f"{name}[{index}]", float(value) if dtype == '<f8' else value
+                    index += 1
+
+def map_dump(filename):
+    """[(name, array)] of a binary dump, memory-mapped through numpy without copying."""
+    records = []
+    size = os.path.getsize(filename)
+    with open(filename, 'rb') as f:
+        f.read(len(DUMP_MAGIC))
+        while header := record_header(f, filename):
+            name, dtype, length = header
+            offset = f.tell()
+            if offset + 8 * length > size:
+                raise ValueError(f"{filename}: {name} truncated")
+            if length:
+                values = np.memmap(filename, dtype=dtype, mode='r', offset=offset, shape=(length,))
+            else:
+                values = np.empty(0, dtype=dtype)
+            records.append((name, values))
+            f.seek(offset + 8 * length)
+    return records
+
+def record_pairs(records):
+    """(NAME[i], value) pairs of mapped records, converted CHUNK elements at a time."""
+    for name, values in records:
+        for start in range(0, len(values), CHUNK):
+            for index, value in enumerate(values[start:start + CHUNK].tolist(), start):
+                yield f"{name}[{index}]", value
+
+def is_dump(filename):
+    with open(filename, 'rb') as f:
+        return f.read(len(DUMP_MAGIC)) == DUMP_MAGIC
+
+def read_output(filename):
+    return read_dump(filename) if is_dump(filename) else read_text(filename)
+
+def ulp_distance(a, b):
+    """Number of representable doubles between a and b."""
+    def ordered(x):
+        bits = struct.unpack('<Q', struct.pack('<d', x))[0]
+        return bits if bits < 1 << 63 else (1 << 63) - bits
+    return abs(ordered(a) - ordered(b))
+
+def ulp_distances(a, b):
+    """ulp_distance() of two float64 arrays, elementwise as uint64."""
+    def ordered(x):
+        bits = x.view('<i8').astype(np.int64)
+        return np.where(bits < 0, -(bits & np.int64(0x7fffffffffffffff)), bits)
+    oa, ob = ordered(a), ordered(b)
+    ua, ub = oa.astype(np.uint64), ob.astype(np.uint64)
+    return np.where(oa >= ob, ua - ub, ub - ua)
+
+def ulp_bucket(ulp):
+    for index, high in enumerate(ULP_BUCKETS):
+        if ulp <= high:
+            return index
+    return len(ULP_BUCKETS)
+
+def ulp_histogram(counts):
+    labels = []
+    low = 0
+    for high, count in zip(ULP_BUCKETS, counts):
+        labels.append(f"{low}:{count}" if low == high else f"{low}-{high}:{count}")
+        low = high + 1
+    labels.append(f"{low}+:{counts[-1]}")
+    return ' '.join(labels)
+
+class Budget:
+    """Accepted error for the keys matching any of patterns, with the maxima observed."""
+    BOUNDS = ('abs', 'rel', 'ulp')
+
+    def __init__(self, patterns=('*',), abs=None, rel=None, ulp=None):
+        self.patterns = list(patterns)
+        # Only '*' is special: keys contain brackets, so fnmatch classes would get in the way
+        self.regex = re.compile('|'.join('(?:' + re.escape(p).replace(r'\*', '.*') + ')'
+                                         for p in self.patterns) + r'\Z')
+        self.abs, self.rel, self.ulp = abs, rel, ulp
+        self.keys = 0
+        self.failed = 0
+        self.max_abs = 0.0
+        self.max_rel = 0.0
+        self.max_ulp = 0
+
+    @classmethod
+    def from_table(cls, table, patterns, where):
+        unknown = set(table) - set(cls.BOUNDS) - {'keys'}
+        if unknown:
+            raise ValueError(f"{where}: unknown field {sorted(unknown)[0]}")
+        bounds = {b: table[b] for b in cls.BOUNDS if b in table}
+        if not bounds:
+            raise ValueError(f"{where}: needs at least one of abs, rel, ulp")
+        return cls(patterns, **bounds)
 
-    cilk = parse_output(sys.argv[1])
-    openmp = parse_output(sys.argv[2])
-
-    tolerance = 1e-12
-    passed = True
-
-    for key in cilk:
-        if key not in openmp:
-            print(f"MISSING: {key} not in OpenMP output")
-            passed = False
-            continue
-
-        cv, ov = cilk[key], openmp[key]
-        if isinstance(cv, float) and isinstance(ov, float):
-            diff = abs(cv - ov)
-            rel_diff = diff / max(abs(cv), 1e-15)
-            if diff > tolerance:
-                print(f"MISMATCH: {key} cilk={cv} openmp={ov} diff={diff:.2e} rel={rel_diff:.2e}")
-                passed = False
+    def matches(self, key):
+        return self.regex.match(key) is not None
+
+    def names_elements(self):
+        """Whether a pattern could match only some elements NAME[i] of an array."""
+        return any(c.isdigit() or c in '[]' for p in self.patterns for c in p)
+
+    def allows(self, diff, rel_diff, ulp):
+        return (self.abs is not None and diff <= self.abs) or \
+            (self.rel is not None and rel_diff <= self.rel) or \
+            (self.ulp is not None and ulp <= self.ulp)
+
+    def record(self, keys, failed, max_abs, max_rel, max_ulp):
+        self.keys += keys
+        self.failed += failed
+        self.max_abs = max(self.max_abs, max_abs)
+        self.max_rel = max(self.max_rel, max_rel)
+        self.max_ulp = max(self.max_ulp, max_ulp)
+
+    def describe(self):
+        bounds = ' '.join(f"{b}<={getattr(self, b):g}" for b in self.BOUNDS
+                          if getattr(self, b) is not None)
+        return f"{','.join(self.patterns)} ({bounds})"
+
+class Budgets:
+    def __init__(self, budgets=(), default=None, configured=False):
+        self.budgets = list(budgets) + [default or Budget(abs=DEFAULT_TOLERANCE)]
+        self.configured = configured
+
+    @classmethod
+    def load(cls, path):
+        with open(path, 'rb') as f:
+            config = tomllib.load(f)
+        unknown = set(config) - {'default', 'budget'}
+        if unknown:
+            raise ValueError(f"unknown table [{sorted(unknown)[0]}]")
+        default = None
+        if 'default' in config:
+            default = Budget.from_table(config['default'], ['*'], '[default]')
+        budgets = []
+        for index, table in enumerate(config.get('budget', []), 1):
+            keys = table.get('keys')
+            if isinstance(keys, str):
+                keys = [keys]
+            if not keys or not all(isinstance(k, str) for k in keys):
+                raise ValueError(f"[[budget]] {index}: keys must be a pattern or a list of patterns")
+            budgets.append(Budget.from_table(table, keys, f"[[budget]] {index}"))
+        return cls(budgets, default, configured=True)
+
+    def lookup(self, key):
+        return next(b for b in self.budgets if b.matches(key))
+
+    def for_record(self, name):
+        """The budget of every key NAME[i], or None if they may differ."""
+        for budget in self.budgets:
+            # '*' cannot appear in a real key, so this matches NAME[i] for every i
+            if budget.matches(f"{name}[*]"):
+                return budget
+            if budget.names_elements():
+                return None
+        return self.budgets[-1]
+
+class StreamingComparison:
+    def __init__(self, budgets=None, ulp=False, quiet=False, fail_fast=False, worst=5):
+        self.budgets = budgets or Budgets()
+        self.ulp = ulp
+        self.quiet = quiet
+        self.fail_fast = fail_fast
+        self.worst_count = worst
+        self.passed = True
+        self.compared = 0
+        self.max_abs = (0.0, None)
+        self.max_rel = (0.0, None)
+        self.max_ulp = (-1, None)
+        self.ulp_counts = [0] * (len(ULP_BUCKETS) + 1)
+        # Min-heap of (score, key, cilk, openmp) holding the worst_count largest scores
+        self.worst = []
+
+    def fail(self, message):
+        print(message)
+        self.passed = False
+        return self.fail_fast
+
+    def push_worst(self, entry):
+        if len(self.worst) < self.worst_count:
+            heapq.heappush(self.worst, entry)
+        elif self.worst_count and entry[0] > self.worst[0][0]:
+            heapq.heapreplace(self.worst, entry)
+
+    @staticmethod
+    def largest(values):
+        """(index, value) of the largest element of values; NaN never wins."""
+        if values.dtype.kind == 'f':
+            values = np.where(np.isnan(values), -1.0, values)
+        index = int(np.argmax(values))
+        return index, values[index].item()
+
+    def raise_max(self, current, values, name):
+        """current, or (largest element of values, its key) if that is larger."""
+        index, value = self.largest(values)
+        return (value, f"{name}[{index}]") if value > current[0] else current
+
+    def compare(self, key, cv, ov):
+        """Compare one key; returns True when the run should stop."""
+        self.compared += 1
+        if not (isinstance(cv, float) and isinstance(ov, float)):
+            if cv != ov:
+                return self.fail(f"MISMATCH: {key} cilk={cv} openmp={ov}")
+            if not self.quiet:
+                print(f"OK: {key} = {cv}")
+            return False
+
+        budget = self.budgets.lookup(key)
+        # Equal values, infinities and NaNs included, are exact matches
+        same = cv == ov or (math.isnan(cv) and math.isnan(ov))
+        diff = 0.0 if same else abs(cv - ov)
+        rel_diff = diff / max(abs(cv), 1e-15)
+        self.max_abs = max(self.max_abs, (diff, key), key=lambda e: e[0])
+        self.max_rel = max(self.max_rel, (rel_diff, key), key=lambda e: e[0])
+        score = diff
+        ulp = ''
+        distance = 0
+        if self.ulp or budget.ulp is not None:
+            distance = 0 if same else ulp_distance(cv, ov)
+            ulp = f" ulp={distance}"
+        if self.ulp:
+            self.ulp_counts[ulp_bucket(distance)] += 1
+            self.max_ulp = max(self.max_ulp, (distance, key), key=lambda e: e[0])
+            score = distance
+        if score > 0:
+            self.push_worst((score, key, cv, ov))
+
+        allowed = budget.allows(diff, rel_diff, distance)
+        budget.record(1, not allowed, diff, rel_diff, distance)
+        if not allowed:
+            return self.fail(f"MISMATCH: {key} cilk={cv} openmp={ov} "
+                             f"diff={diff:.2e} rel={rel_diff:.2e}{ulp}")
+        if not self.quiet:
+            print(f"OK: {key} diff={diff:.2e}{ulp}")
+        return False
+
+    def run(self, cilk, openmp):
+        """Walk both (key, value) streams in lockstep, buffering keys not yet seen on the other side."""
+        cilk = ((k, v) for k, v in cilk if not k.startswith(TIMING_PREFIXES))
+        pending_cilk = {}
+        pending_openmp = {}
+        while cilk or openmp:
+            if cilk:
+                entry = next(cilk, None)
+                if entry is None:
+                    cilk = None
+                else:
+                    key, cv = entry
+                    if key in pending_openmp:
+                        if self.compare(key, cv, pending_openmp.pop(key)):
+                            return self
+                    else:
+                        pending_cilk[key] = cv
+            if openmp:
+                entry = next(openmp, None)
+                if entry is None:
+                    openmp = None
+                else:
+                    key, ov = entry
+                    if key in pending_cilk:
+                        if self.compare(key, pending_cilk.pop(key), ov):
+                            return self
+                    elif cilk:
+                        pending_openmp[key] = ov
+            # Extra OpenMP keys never match once the reference has ended
+            if not cilk:
+                pending_openmp.clear()
+
+        for key in pending_cilk:
+            if self.fail(f"MISSING: {key} not in OpenMP output"):
+                break
+        return self
+
+    def compare_arrays(self, name, cilk, openmp):
+        """compare() each element of two equal-length records; returns True when the run should stop."""
+        budget = self.budgets.for_record(name)
+        if not self.quiet or cilk.dtype != openmp.dtype or not len(cilk) or budget is None:
+            for start in range(0, len(cilk), CHUNK):
+                pairs = zip(cilk[start:start + CHUNK].tolist(), openmp[start:start + CHUNK].tolist())
+                for index, (cv, ov) in enumerate(pairs, start):
+                    if self.compare(f"{name}[{index}]", cv, ov):
+                        return True
+            return False
+
+        if cilk.dtype.kind != 'f':
+            failed = np.flatnonzero(cilk != openmp)
+            if self.fail_fast and len(failed):
+                failed = failed[:1]
+                self.compared += int(failed[0]) + 1
             else:
-                print(f"OK: {key} diff={diff:.2e}")
-        elif cv != ov:
-            print(f"MISMATCH: {key} cilk={cv} openmp={ov}")
-            passed = False
-        else:
-            print(f"OK: {key} = {cv}")
-
-    if passed:
+                self.compared += len(cilk)
+            for i in failed:
+                self.fail(f"MISMATCH: {name}[{i}] cilk={cilk[i].item()} openmp={openmp[i].item()}")
+            return self.fail_fast and len(failed) > 0
+
+        with np.errstate(invalid='ignore'):
+            same = (cilk == openmp) | (np.isnan(cilk) & np.isnan(openmp))
+            diff = np.where(same, 0.0, np.abs(cilk - openmp))
+            rel_diff = diff / np.maximum(np.abs(cilk), 1e-15)
+        distance = None
+        if self.ulp or budget.ulp is not None:
+            distance = np.where(same, np.uint64(0), ulp_distances(cilk, openmp))
+        allowed = np.zeros(len(cilk), dtype=bool)
+        if budget.abs is not None:
+            allowed |= diff <= budget.abs
+        if budget.rel is not None:
+            allowed |= rel_diff <= budget.rel
+        if budget.ulp is not None:
+            allowed |= distance <= np.uint64(budget.ulp)
+        failed = np.flatnonzero(~allowed)
+        if self.fail_fast and len(failed):
+            end = int(failed[0]) + 1
+            cilk, openmp, diff, rel_diff, failed = \
+                cilk[:end], openmp[:end], diff[:end], rel_diff[:end], failed[:1]
+            if distance is not None:
+                distance = distance[:end]
+        self.compared += len(cilk)
+        self.max_abs = self.raise_max(self.max_abs, diff, name)
+        self.max_rel = self.raise_max(self.max_rel, rel_diff, name)
+        budget.record(len(cilk), len(failed), self.largest(diff)[1], self.largest(rel_diff)[1],
+                      self.largest(distance)[1] if distance is not None else 0)
+        score = diff
+        if self.ulp:
+            buckets = np.searchsorted(np.array(ULP_BUCKETS, dtype=np.uint64), distance)
+            counts = np.bincount(buckets, minlength=len(self.ulp_counts))
+            self.ulp_counts = [total + int(n) for total, n in zip(self.ulp_counts, counts)]
+            self.max_ulp = self.raise_max(self.max_ulp, distance, name)
+            score = distance
+
+        worst = np.flatnonzero(score > 0)
+        if len(worst) > self.worst_count:
+            keep = np.argpartition(score[worst], -self.worst_count)[-self.worst_count:] \
+                if self.worst_count else []
+            worst = worst[keep]
+        for i in worst:
+            self.push_worst((score[i].item(), f"{name}[{i}]", cilk[i].item(), openmp[i].item()))
+
+        for i in failed:
+            ulp = f" ulp={distance[i]}" if distance is not None else ''
+            self.fail(f"MISMATCH: {name}[{i}] cilk={cilk[i].item()} openmp={openmp[i].item()} "
+                      f"diff={diff[i]:.2e} rel={rel_diff[i]:.2e}{ulp}")
+        return self.fail_fast and len(failed) > 0
+
+    def run_records(self, cilk, openmp):
+        """run() over two mapped dumps, comparing same-named records of equal length whole."""
+        openmp = dict(openmp)
+        unmatched = []
+        for name, values in cilk:
+            if name.startswith(TIMING_PREFIXES):
+                continue
+            other = openmp.get(name)
+            if other is None or len(other) != len(values):
+                unmatched.append((name, values))
+            elif self.compare_arrays(name, values, openmp.pop(name)):
+                return self
+        # Missing records and length mismatches are reported key by key
+        return self.run(record_pairs(unmatched), record_pairs(openmp.items()))
+
+    def report(self):
+        if self.compared:
+            def largest(name, entry):
+                value, key = entry
+                return f"{name}={value:.2e}" + (f" ({key})" if key else '')
+            print(f"\nSTATS: compared={self.compared} {largest('max_abs', self.max_abs)} "
+                  f"{largest('max_rel', self.max_rel)}")
+        for score, key, cv, ov in sorted(self.worst, reverse=True):
+            measure = f"ulp={score}" if self.ulp else f"diff={score:.2e}"
+            print(f"WORST: {key} cilk={cv} openmp={ov} {measure}")
+        if self.max_ulp[1] is not None:
+            print(f"\nULP: max={self.max_ulp[0]} ({self.max_ulp[1]}) "
+                  f"histogram {ulp_histogram(self.ulp_counts)}")
+        if self.budgets.configured:
+            print()
+            for budget in self.budgets.budgets:
+                ulp = f" max_ulp={budget.max_ulp}" if budget.ulp is not None else ''
+                print(f"BUDGET: {budget.describe()} keys={budget.keys} failed={budget.failed} "
+                      f"max_abs={budget.max_abs:.2e} max_rel={budget.max_rel:.2e}{ulp}")
+
+def main():
+    parser = argparse.ArgumentParser(description='Compare Cilk Plus and OpenMP SIMD outputs')
+    parser.add_argument('cilk_output', help='Reference output (Cilk Plus), text or binary dump')
+    parser.add_argument('openmp_output', help='Output under test (OpenMP SIMD), text or binary dump')
+    parser.add_argument('--ulp', action='store_true', help='Report ULP distances')
+    parser.add_argument('--quiet', '-q', action='store_true',
+                        help='Only print mismatches and the summary')
+    parser.add_argument('--fail-fast', action='store_true', help='Stop at the first mismatch')
+    parser.add_argument('--worst', type=int, default=5, metavar='N',
+                        help='Number of largest differences to list (default 5)')
+    parser.add_argument('--budgets', metavar='FILE',
+                        help=f'TOML file of per-key error budgets (default: abs {DEFAULT_TOLERANCE:g})')
+    args = parser.parse_args()
+
+    budgets = None
+    if args.budgets:
+        try:
+            budgets = Budgets.load(args.budgets)
+        except (OSError, ValueError) as e:
+            parser.error(f"{args.budgets}: {e}")
+
+    comparison = StreamingComparison(budgets, ulp=args.ulp, quiet=args.quiet,
+                                     fail_fast=args.fail_fast, worst=max(args.worst, 0))
+    if np is not None and is_dump(args.cilk_output) and is_dump(args.openmp_output):
+        comparison.run_records(map_dump(args.cilk_output), map_dump(args.openmp_output))
+    else:
+        comparison.run(read_output(args.cilk_output), read_output(args.openmp_output))
+    comparison.report()
+
+    if comparison.passed:
         print("\nSUCCESS: All values match within tolerance")
         sys.exit(0)
     else:
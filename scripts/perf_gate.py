@@ -0,0 +1,208 @@
+#!/usr/bin/env python3
+"""Fail when OpenMP SIMD kernels run slower than their Cilk Plus reference.
+
+Each side is a directory of benchmark outputs, one KEY=value file per run of
+a program, named <program>.<run>.txt (simd.1.txt, simd.2.txt, sweep.1.txt,
+...). Every BENCH_<kernel>_NS_PER_ELEM_MEDIAN key that a program prints on
+both sides is one kernel, e.g. sweep:BENCH_N4096; --metric min or p99 uses
+the other per-element statistics of bench.h instead.
+
+A single run already reports a median over BENCH_REPS samples, but runs
+vary with the machine's state, so the gate works on repeated runs. For each
+kernel it takes the median over runs on each side and their ratio,
+openmp / cilk, with a percentile bootstrap confidence interval (both sides
+resampled independently, seeded so a result can be reproduced). Verdicts:
+
+    faster        the whole interval is below 1
+    neutral       the interval's upper bound is within 1 + threshold
+    inconclusive  the interval straddles 1 + threshold; more runs narrow it
+    SLOWER        the whole interval is above 1 + threshold
+
+The gate fails on any SLOWER kernel, and with --require-neutral on any
+inconclusive one too, so a port has to be shown performance-neutral rather
+than merely not shown slower. Without it, inconclusive kernels end in an
+INCONCLUSIVE result instead of SUCCESS, still with exit status 0. Kernels
+timed on one side only are listed and skipped. Both sides should be timed
+on one machine, since a ratio across machines includes their difference.
+
+Usage:
+    python perf_gate.py cilk_timings/ openmp_timings/ [--threshold 0.05]
+        [--confidence 0.95] [--metric median|min|p99] [--require-neutral]
+        [--resamples N] [--seed S] [--json FILE]
+"""
+
+import re
+import sys
+import json
+import random
+import argparse
+import statistics
+from pathlib import Path
+
+from compare_outputs import read_text
+
+METRICS = {'median': '_NS_PER_ELEM_MEDIAN', 'min': '_NS_PER_ELEM_MIN', 'p99': '_NS_PER_ELEM_P99'}
+
+# <program>.<run>.txt; a name without a run number is a single run
+RUN_FILE = r'(.+?)(?:\.(\d+))?\.txt'
+
+# Fewer runs per side than this make the interval too coarse to trust
+MIN_RUNS = 5
+
+
+class Timings:
+    """Per-run timings of one side: {kernel: [ns per element, one per run]}."""
+
+    def __init__(self, directory, metric):
+        self.directory = Path(directory)
+        self.kernels = {}
+        self.info = {}   # non-numeric BENCH_* values, such as the ISA clone
+        suffix = METRICS[metric]
+        files = sorted(self.directory.glob('*.txt'))
+        if not files:
+            raise ValueError(f"no <program>.<run>.txt files in {directory}")
+        for path in files:
+            program = re.fullmatch(RUN_FILE, path.name).group(1)
+            for key, value in read_text(path):
+                if not key.startswith('BENCH'):
+                    continue
+                if isinstance(value, str):
+                    self.info.setdefault(f'{program}:{key}', set()).add(value)
+                elif key.endswith(suffix):
+                    self.kernels.setdefault(f'{program}:{key[:-len(suffix)]}', []).append(value)
+
+
+class PerfGate:
+    def __init__(self, threshold=0.05, confidence=0.95, resamples=10000, seed=1,
+                 require_neutral=False):
+        self.threshold = threshold
+        self.confidence = confidence
+        self.resamples = resamples
+        self.random = random.Random(seed)
+        self.require_neutral = require_neutral
+        self.results = []
+        self.warnings = []
+
+    def interval(self, cilk, openmp):
+        """Bootstrap confidence interval of median(openmp) / median(cilk)."""
+        ratios = sorted(
+            statistics.median(self.random.choices(openmp, k=len(openmp))) /
+            statistics.median(self.random.choices(cilk, k=len(cilk)))
+            for _ in range(self.resamples))
+        tail = (1 - self.confidence) / 2
+        low = ratios[int(tail * (self.resamples - 1))]
+        high = ratios[int(round((1 - tail) * (self.resamples - 1)))]
+        return low, high
+
+    def verdict(self, low, high):
+        limit = 1 + self.threshold
+        if high < 1:
+            return 'faster'
+        if high <= limit:
+            return 'neutral'
+        if low > limit:
+            return 'SLOWER'
+        return 'inconclusive'
+
+    def evaluate(self, cilk, openmp):
+        for kernel in sorted(cilk.kernels.keys() - openmp.kernels.keys()):
+            self.warnings.append(f"MISSING: {kernel} only timed for Cilk Plus")
+        for kernel in sorted(openmp.kernels.keys() - cilk.kernels.keys()):
+            self.warnings.append(f"MISSING: {kernel} only timed for OpenMP SIMD")
+
+        for kernel in sorted(cilk.kernels.keys() & openmp.kernels.keys()):
+            c, o = cilk.kernels[kernel], openmp.kernels[kernel]
+            if min(len(c), len(o)) < MIN_RUNS:
+                self.warnings.append(f"WARNING: {kernel} has {len(c)}/{len(o)} runs, "
+                                     f"the interval needs at least {MIN_RUNS} per side")
+            cilk_ns, openmp_ns = statistics.median(c), statistics.median(o)
+            low, high = self.interval(c, o)
+            self.results.append({
+                'kernel': kernel, 'cilk_ns': cilk_ns, 'openmp_ns': openmp_ns,
+                'ratio': openmp_ns / cilk_ns, 'ci_low': low, 'ci_high': high,
+                'cilk_runs': len(c), 'openmp_runs': len(o), 'verdict': self.verdict(low, high),
+            })
+        return self
+
+    @property
+    def passed(self):
+        failing = {'SLOWER', 'inconclusive'} if self.require_neutral else {'SLOWER'}
+        return bool(self.results) and not any(r['verdict'] in failing for r in self.results)
+
+    def report(self, cilk, openmp):
+        for side, timings in (('cilk', cilk), ('openmp', openmp)):
+            for key, values in sorted(timings.info.items()):
+                print(f"INFO: {side} {key}={','.join(sorted(values))}")
+        for w in self.warnings:
+            print(w)
+        level = int(self.confidence * 100)
+        for r in self.results:
+            print(f"PERF: {r['kernel']} cilk={r['cilk_ns']:.4f} openmp={r['openmp_ns']:.4f} ns/elem "
+                  f"ratio={r['ratio']:.3f} ci{level}=[{r['ci_low']:.3f}, {r['ci_high']:.3f}] "
+                  f"runs={r['cilk_runs']}/{r['openmp_runs']} {r['verdict']}")
+        counts = {v: sum(r['verdict'] == v for r in self.results)
+                  for v in ('faster', 'neutral', 'inconclusive', 'SLOWER')}
+        print(f"\nGATE: kernels={len(self.results)} threshold={self.threshold:.1%} " +
+              ' '.join(f'{v.lower()}={n}' for v, n in counts.items()))
+
+    def write_json(self, path):
+        with open(path, 'w') as f:
+            json.dump({'threshold': self.threshold, 'confidence': self.confidence,
+                       'require_neutral': self.require_neutral, 'passed': self.passed,
+                       'kernels': self.results, 'warnings': self.warnings}, f, indent=2)
+            f.write('\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Gate OpenMP SIMD timings against Cilk Plus')
+    parser.add_argument('cilk_timings', help='Directory of Cilk Plus <program>.<run>.txt outputs')
+    parser.add_argument('openmp_timings', help='Directory of OpenMP SIMD <program>.<run>.txt outputs')
+    parser.add_argument('--threshold', type=float, default=0.05,
+                        help='Allowed slowdown, as a fraction of the Cilk time (default 0.05)')
+    parser.add_argument('--confidence', type=float, default=0.95,
+                        help='Confidence level of the intervals (default 0.95)')
+    parser.add_argument('--metric', choices=sorted(METRICS), default='median',
+                        help='Per-run statistic compared (default: median)')
+    parser.add_argument('--require-neutral', action='store_true',
+                        help='Also fail kernels whose interval reaches past the threshold')
+    parser.add_argument('--resamples', type=int, default=10000, metavar='N',
+                        help='Bootstrap resamples (default 10000)')
+    parser.add_argument('--seed', type=int, default=1, help='Bootstrap seed (default 1)')
+    parser.add_argument('--json', metavar='FILE', help='Also write the results as JSON')
+    args = parser.parse_args()
+
+    if args.threshold < 0 or not 0 < args.confidence < 1 or args.resamples < 1:
+        parser.error("--threshold must be >= 0, --confidence in (0, 1) and --resamples >= 1")
+    try:
+        cilk = Timings(args.cilk_timings, args.metric)
+        openmp = Timings(args.openmp_timings, args.metric)
+    except (OSError, ValueError) as e:
+        parser.error(str(e))
+
+    gate = PerfGate(args.threshold, args.confidence, args.resamples, args.seed,
+                    args.require_neutral).evaluate(cilk, openmp)
+    gate.report(cilk, openmp)
+    if args.json:
+        gate.write_json(args.json)
+
+    if not gate.results:
+        print("\nFAILURE: No kernel was timed on both sides")
+        sys.exit(1)
+    inconclusive = [r['kernel'] for r in gate.results if r['verdict'] == 'inconclusive']
+    if gate.passed and inconclusive:
+        print(f"\nINCONCLUSIVE: OpenMP SIMD is not shown slower, but {len(inconclusive)} kernels are not "
+              f"shown within the threshold ({', '.join(inconclusive)}); add runs, or pass "
+              f"--require-neutral to fail on them")
+        sys.exit(0)
+    if gate.passed:
+        print("\nSUCCESS: OpenMP SIMD is within the threshold of Cilk Plus")
+        sys.exit(0)
+    elif any(r['verdict'] == 'SLOWER' for r in gate.results):
+        print("\nFAILURE: OpenMP SIMD is slower than Cilk Plus beyond the threshold")
+        sys.exit(1)
+    else:
+        print("\nFAILURE: OpenMP SIMD is not shown to be within the threshold; add runs")
+        sys.exit(1)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,238 @@
+#!/usr/bin/env python3
+"""Thread scaling of the threaded kernels, OpenMP against Cilk Plus.
+
+Builds src/scaling_runner.c once per runtime: with src/scaling_cilk.c by
+CILK_CC (default gcc-7, skipped when it is not installed) and with
+src/scaling_openmp.c by OMP_CC (default gcc), both with CFLAGS (default
+-O2). Then it runs the Cilk runner with CILK_NWORKERS set to every thread
+count and the OpenMP runner with OMP_NUM_THREADS set to every thread count
+under every placement. A placement is an OMP_PROC_BIND value, optionally
+followed by ':' and an OMP_PLACES value:
+
+    false           threads are not bound (OMP_PLACES unset)
+    close:cores     consecutive threads on neighbouring cores
+    spread:sockets  threads spread evenly over the sockets (NUMA nodes)
+
+The runner first-touches its buffers with the runtime's threads, so pages
+land on the NUMA node of the thread that will use them (scaling.h). For
+every variant, size and placement the report shows, per thread count T:
+
+    ns/elem     median over BENCH_REPS samples (--reps)
+    speedup     the variant's own time at the smallest T swept, divided by
+                its time at T
+    efficiency  speedup * smallest T / T
+    vs_cilk     time of the Cilk variant it was converted from at the same
+                T, divided by its time; above 1 OpenMP is faster
+
+openmp-for and openmp-parallel are compared with cilk-for, openmp-tasks with
+cilk-spawn. Thread counts above the CPU count are run but flagged, since
+oversubscribed timings say little about either runtime.
+
+Usage:
+    python scaling.py [--threads 1,2,4,8] [--bind false,close:cores,spread:cores]
+        [--reps N] [--csv FILE] [N ...]
+"""
+
+import os
+import csv
+import sys
+import shutil
+import argparse
+import subprocess
+from pathlib import Path
+
+ROOT = Path(__file__).resolve().parent.parent
+
+# The Cilk variant each OpenMP variant is the conversion of
+CILK_REFERENCE = {'openmp-for': 'cilk-for', 'openmp-tasks': 'cilk-spawn', 'openmp-parallel': 'cilk-for'}
+
+DEFAULT_BINDINGS = 'false,close:cores,spread:cores'
+
+# Block variants combine their blocks in order, so only the rounding of
+# openmp-parallel, which sums each thread's range in SIMD lanes instead of
+# block by block, differs; over 8M elements that reaches about 1e-11
+SUM_TOLERANCE = 1e-10
+
+
+def default_threads():
+    """Powers of two up to the CPU count, and the CPU count itself."""
+    cpus = os.cpu_count() or 1
+    counts = [1]
+    while counts[-1] * 2 <= cpus:
+        counts.append(counts[-1] * 2)
+    return sorted(set(counts) | {cpus})
+
+
+def parse_binding(text):
+    """'close:cores' -> ('close', 'cores'); 'false' -> ('false', None)."""
+    bind, _, places = text.partition(':')
+    return bind, places or None
+
+
+class ScalingSweep:
+    def __init__(self, threads, bindings, sizes, reps, build_dir):
+        self.threads = threads
+        self.bindings = bindings
+        self.sizes = [str(n) for n in sizes]
+        self.reps = reps
+        self.build_dir = Path(build_dir).resolve()
+        self.rows = []
+        self.warnings = []
+
+    def log(self, msg):
+        self.warnings.append(msg)
+
+    def build(self):
+        """Compiles the runners; returns {runtime: executable} for those that built."""
+        cflags = os.environ.get('CFLAGS', '-O2').split()
+        cilk_cc = os.environ.get('CILK_CC', 'gcc-7')
+        omp_cc = os.environ.get('OMP_CC', 'gcc')
+        runner = str(ROOT / 'src' / 'scaling_runner.c')
+        targets = {
+            'openmp': [omp_cc, '-fopenmp', *cflags, runner, str(ROOT / 'src' / 'scaling_openmp.c'), '-lm'],
+            'cilk': [cilk_cc, '-fcilkplus', *cflags, runner, str(ROOT / 'src' / 'scaling_cilk.c'),
+                     '-lcilkrts', '-lm'],
+        }
+        built = {}
+        for runtime, command in targets.items():
+            if shutil.which(command[0]) is None:
+                self.log(f"WARNING: {command[0]} not found, {runtime} is not measured")
+                continue
+            exe = self.build_dir / f'scaling_{runtime}'
+            subprocess.run(command + ['-o', str(exe)], check=True)
+            built[runtime] = exe
+        return built
+
+    def run(self, exe, env_vars):
+        env = dict(os.environ, BENCH_REPS=str(self.reps), **env_vars)
+        for name in ('OMP_PROC_BIND', 'OMP_PLACES'):
+            if name not in env_vars:
+                env.pop(name, None)
+        proc = subprocess.run([str(exe), *self.sizes], env=env, capture_output=True, text=True)
+        if proc.returncode != 0:
+            raise RuntimeError(f"{exe.name} failed with {env_vars}: {proc.stderr.strip()}")
+        for row in csv.DictReader(proc.stdout.splitlines()):
+            row['placement'] = '-' if 'CILK_NWORKERS' in env_vars else row['proc_bind'] + (
+                f":{row['places']}" if row['places'] else '')
+            self.rows.append(row)
+
+    def sweep(self, runners):
+        cpus = os.cpu_count() or 1
+        for t in self.threads:
+            if t > cpus:
+                self.log(f"WARNING: {t} threads oversubscribe the {cpus} CPUs")
+            if 'cilk' in runners:
+                self.run(runners['cilk'], {'CILK_NWORKERS': str(t)})
+            for bind, places in self.bindings:
+                env = {'OMP_NUM_THREADS': str(t), 'OMP_PROC_BIND': bind}
+                if places:
+                    env['OMP_PLACES'] = places
+                if 'openmp' in runners:
+                    self.run(runners['openmp'], env)
+        return self
+
+    def reported_sizes(self):
+        """Sizes the runners reported: the ones given, or SCALING_SIZES by default."""
+        return sorted({r['n'] for r in self.rows}, key=int)
+
+    def analyze(self):
+        """Adds speedup, efficiency and vs_cilk to every row and checks the results agree."""
+        median = {}
+        for row in self.rows:
+            row['threads'] = int(row['threads'])
+            row['median_ns'] = float(row['median_ns'])
+            median[(row['variant'], row['placement'], row['n'], row['threads'])] = row['median_ns']
+        for row in self.rows:
+            base_threads = min(r['threads'] for r in self.rows
+                               if (r['variant'], r['placement'], r['n']) == (row['variant'], row['placement'], row['n']))
+            base = median[(row['variant'], row['placement'], row['n'], base_threads)]
+            row['speedup'] = base / row['median_ns']
+            row['efficiency'] = row['speedup'] * base_threads / row['threads']
+            cilk = median.get((CILK_REFERENCE.get(row['variant']), '-', row['n'], row['threads']))
+            row['vs_cilk'] = cilk / row['median_ns'] if cilk else None
+
+        for n in self.reported_sizes():
+            rows = [r for r in self.rows if r['n'] == n]
+            ref = rows[0]
+            for row in rows[1:]:
+                if row['count'] != ref['count']:
+                    self.log(f"MISMATCH: n={n} {row['variant']} T={row['threads']} count "
+                             f"{row['count']} != {ref['count']} ({ref['variant']})")
+                for key in ('sum', 'sum2'):
+                    a, b = float(row[key]), float(ref[key])
+                    if abs(a - b) > SUM_TOLERANCE * max(abs(a), abs(b)):
+                        self.log(f"MISMATCH: n={n} {row['variant']} T={row['threads']} {key} "
+                                 f"{a!r} != {b!r} ({ref['variant']})")
+        return self
+
+    def report(self):
+        for w in self.warnings:
+            print(w)
+        for n in self.reported_sizes():
+            print(f"\nn={n}")
+            print(f"{'variant':<16} {'placement':<16} {'T':>4} {'ns/elem':>9} {'speedup':>8} "
+                  f"{'efficiency':>10} {'vs_cilk':>8}")
+            for row in sorted((r for r in self.rows if r['n'] == n),
+                              key=lambda r: (r['runtime'], r['variant'], r['placement'], r['threads'])):
+                vs_cilk = f"{row['vs_cilk']:.3f}" if row['vs_cilk'] else '-'
+                print(f"{row['variant']:<16} {row['placement']:<16} {row['threads']:>4} "
+                      f"{row['median_ns']:>9.4f} {row['speedup']:>8.3f} {row['efficiency']:>10.3f} "
+                      f"{vs_cilk:>8}")
+
+    def write_csv(self, path):
+        fields = list(self.rows[0].keys())
+        with open(path, 'w', newline='') as f:
+            writer = csv.DictWriter(f, fieldnames=fields)
+            writer.writeheader()
+            writer.writerows(self.rows)
+
+
+def thread_list(text):
+    counts = [int(t) for t in text.split(',')]
+    if any(t <= 0 for t in counts):
+        raise argparse.ArgumentTypeError('thread counts must be positive')
+    return sorted(set(counts))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Thread scaling of OpenMP and Cilk Plus kernels')
+    parser.add_argument('sizes', nargs='*', type=int, metavar='N',
+                        help='Elements per kernel call (default: SCALING_SIZES of the runner)')
+    parser.add_argument('--threads', type=thread_list, default=default_threads(),
+                        help='Comma-separated thread counts (default: powers of two up to the CPU count)')
+    parser.add_argument('--bind', default=DEFAULT_BINDINGS,
+                        help=f'Comma-separated OMP_PROC_BIND[:OMP_PLACES] placements (default: {DEFAULT_BINDINGS})')
+    parser.add_argument('--reps', type=int, default=21, help='BENCH_REPS per run (default 21)')
+    parser.add_argument('--build-dir', default='.', help='Where the runners are built (default: .)')
+    parser.add_argument('--csv', metavar='FILE', help='Also write every row with its derived columns')
+    args = parser.parse_args()
+
+    if any(n <= 0 for n in args.sizes) or args.reps <= 0:
+        parser.error('sizes and --reps must be positive')
+    bindings = [parse_binding(b) for b in args.bind.split(',') if b]
+
+    sweep = ScalingSweep(args.threads, bindings, args.sizes, args.reps, args.build_dir)
+    runners = sweep.build()
+    if 'openmp' not in runners:
+        parser.error('the OpenMP runner could not be built')
+    try:
+        sweep.sweep(runners)
+    except RuntimeError as e:
+        print(f"FAILURE: {e}")
+        sys.exit(1)
+    if not sweep.rows:
+        for w in sweep.warnings:
+            print(w)
+        print("FAILURE: the runners reported no results")
+        sys.exit(1)
+    sweep.analyze()
+    sweep.report()
+    if args.csv:
+        sweep.write_csv(args.csv)
+    if any(w.startswith('MISMATCH') for w in sweep.warnings):
+        print("\nFAILURE: variants disagree on the kernel results")
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
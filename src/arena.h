@@ -0,0 +1,106 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+/*
+ * Thread-local bump allocator for section temporaries.
+ *
+ * Cilk Plus code declares temporaries as VLAs, double tmp[n], and for large
+ * runtime lengths those can overflow the stack (8 MB on the main thread,
+ * often far less on worker threads). malloc/free per call is safe but costs a
+ * system call per call once n * 8 bytes passes the mmap threshold (128 KB by
+ * default), plus fresh page faults. Here each thread owns one ARENA_BYTES
+ * buffer, reserved on first use; an allocation bumps an offset, rounded up
+ * to ARENA_ALIGN so every temporary starts on a cache line, and leaving a
+ * scope resets the offset:
+ *
+ *     {
+ *         ARENA_SCOPE;
+ *         double *tmp = arena_alloc(n, sizeof(double));
+ *         ...
+ *     }   // tmp released here, also on return, break or goto
+ *
+ * ARENA_SCOPE uses the GCC/Clang cleanup attribute. Scopes nest: a
+ * temporary lives until the end of the innermost ARENA_SCOPE block around
+ * it. Reserving touches no memory, so only the high-water mark of each
+ * thread becomes resident. A thread's buffer is freed when the thread exits,
+ * through a pthread key destructor, so short-lived threads (a new OpenMP
+ * team, say) do not leak address space; the main thread's buffer is
+ * released with the process. Memory from arena_alloc() must not be used
+ * after its thread exits. Build with -DARENA_BYTES=N to reserve another
+ * size per thread, and with -pthread where libpthread is separate from libc
+ * (glibc before 2.34).
+ *
+ * The converter's --arena mode rewrites VLA temporaries used in sections
+ * this way.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#ifndef ARENA_BYTES
+#define ARENA_BYTES ((size_t)256 << 20)  // per thread
+#endif
+
+#define ARENA_ALIGN 64
+
+typedef struct {
+    char *base;
+    size_t used;
+} arena;
+
+// Each thread's buffer, freed by the key's destructor when the thread exits
+static pthread_key_t arena_key;
+static pthread_once_t arena_key_once = PTHREAD_ONCE_INIT;
+
+static inline void arena_key_create(void) {
+    if (pthread_key_create(&arena_key, free) != 0) {
+        fprintf(stderr, "arena: cannot create the thread-exit key\n");
+        exit(1);
+    }
+}
+
+static inline arena *arena_local(void) {
+    static _Thread_local arena local;
+    if (!local.base) {
+        pthread_once(&arena_key_once, arena_key_create);
+        local.base = aligned_alloc(ARENA_ALIGN, ARENA_BYTES);
+        if (!local.base || pthread_setspecific(arena_key, local.base) != 0) {
+            fprintf(stderr, "arena: cannot reserve %zu bytes\n", (size_t)ARENA_BYTES);
+            exit(1);
+        }
+    }
+    return &local;
+}
+
+// count elements of size bytes, 64-byte aligned, valid until the scope ends
+static inline void *arena_alloc(size_t count, size_t size) {
+    arena *a = arena_local();
+    size_t bytes = (count * size + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+    if (bytes > ARENA_BYTES - a->used) {
+        fprintf(stderr, "arena: %zu bytes requested, %zu of %zu left (raise ARENA_BYTES)\n",
+                bytes, (size_t)ARENA_BYTES - a->used, (size_t)ARENA_BYTES);
+        exit(1);
+    }
+    void *p = a->base + a->used;
+    a->used += bytes;
+    return p;
+}
+
+static inline size_t arena_mark(void) {
+    return arena_local()->used;
+}
+
+// Frees everything allocated since mark was taken
+static inline void arena_release(size_t mark) {
+    arena_local()->used = mark;
+}
+
+static inline void arena_release_scope(size_t *mark) {
+    arena_release(*mark);
+}
+
+#define ARENA_SCOPE size_t arena_scope_ __attribute__((cleanup(arena_release_scope))) = arena_mark()
+
+#endif
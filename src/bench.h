@@ -0,0 +1,217 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+/*
+ * Minimal benchmark harness shared by the Cilk Plus and OpenMP SIMD tests.
+ *
+ * Each sample times one call of the loop body with CLOCK_MONOTONIC. The
+ * first BENCH_WARMUP samples are discarded, and the remaining BENCH_REPS are
+ * summarized as min / median / p99 nanoseconds per element. Both counts can
+ * be overridden at runtime through the environment variables of the same name.
+ *
+ *     bench_run run;
+ *     bench_begin(&run, ITERATIONS * VLENGTH);
+ *     while (bench_next(&run)) {
+ *         ... kernel ...
+ *     }
+ *     bench_end(&run);
+ *     bench_report("BENCH", &run);
+ *
+ * bench_sweep() runs a kernel over heap-allocated arrays for each size in
+ * SWEEP_SIZES (or the sizes given on the command line) and reports one
+ * BENCH_N<size> block per size. Given a dump file (dump.h), it also writes
+ * the full SWEEP_OUTPUT_N<size> and SWEEP_INTERMEDIATE_N<size> arrays.
+ * bench_sum() times a single sum_fn the same way.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include "kernels.h"
+#include "dump.h"
+
+#ifndef BENCH_WARMUP
+#define BENCH_WARMUP 10
+#endif
+
+#ifndef BENCH_REPS
+#define BENCH_REPS 101
+#endif
+
+// Elements per sweep sample, keeping small sizes well above timer resolution
+#ifndef SWEEP_MIN_ELEMENTS
+#define SWEEP_MIN_ELEMENTS 65536
+#endif
+
+typedef struct {
+    int warmup;
+    int reps;
+    int index;              // samples started so far, including warmup
+    double elements;        // elements processed per sample
+    uint64_t t0;
+    double *samples_ns;     // per-sample elapsed time, reps entries
+
+    // Filled by bench_end(), all per element except total_ms
+    double min_ns;
+    double median_ns;
+    double p99_ns;
+    double total_ms;
+} bench_run;
+
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static inline int bench_env_int(const char *name, int fallback) {
+    const char *value = getenv(name);
+    int parsed = value ? atoi(value) : 0;
+    return parsed > 0 ? parsed : fallback;
+}
+
+static inline void bench_begin(bench_run *run, double elements_per_sample) {
+    run->warmup = bench_env_int("BENCH_WARMUP", BENCH_WARMUP);
+    run->reps = bench_env_int("BENCH_REPS", BENCH_REPS);
+    run->index = 0;
+    run->t0 = 0;
+    run->elements = elements_per_sample;
+    run->samples_ns = malloc(sizeof(double) * run->reps);
+    if (!run->samples_ns) {
+        fprintf(stderr, "bench: cannot allocate %d samples\n", run->reps);
+        exit(1);
+    }
+}
+
+// Closes the previous sample and returns nonzero while another should run
+static inline int bench_next(bench_run *run) {
+    uint64_t now = bench_now_ns();
+    if (run->index > run->warmup) {
+        run->samples_ns[run->index - run->warmup - 1] = (double)(now - run->t0);
+    }
+    if (run->index == run->warmup + run->reps) {
+        return 0;
+    }
+    run->index++;
+    run->t0 = bench_now_ns();
+    return 1;
+}
+
+static inline int bench_cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of a sorted array
+static inline double bench_percentile(const double *sorted, int n, double q) {
+    int rank = (int)(q * n + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > n) rank = n;
+    return sorted[rank - 1];
+}
+
+static inline void bench_end(bench_run *run) {
+    int n = run->reps;
+    double total = 0.0;
+    for (int i = 0; i < n; i++) {
+        total += run->samples_ns[i];
+    }
+    qsort(run->samples_ns, n, sizeof(double), bench_cmp_double);
+
+    run->min_ns = run->samples_ns[0] / run->elements;
+    run->median_ns = bench_percentile(run->samples_ns, n, 0.5) / run->elements;
+    run->p99_ns = bench_percentile(run->samples_ns, n, 0.99) / run->elements;
+    run->total_ms = total / 1e6;
+
+    free(run->samples_ns);
+    run->samples_ns = NULL;
+}
+
+static inline void bench_report(const char *name, const bench_run *run) {
+    printf("%s_REPS=%d\n", name, run->reps);
+    printf("%s_NS_PER_ELEM_MIN=%.4f\n", name, run->min_ns);
+    printf("%s_NS_PER_ELEM_MEDIAN=%.4f\n", name, run->median_ns);
+    printf("%s_NS_PER_ELEM_P99=%.4f\n", name, run->p99_ns);
+    printf("%s_MELEM_PER_S=%.2f\n", name, 1e3 / run->median_ns);
+}
+
+// Times kernel over n elements; small n is repeated to fill SWEEP_MIN_ELEMENTS
+static inline int bench_kernel(bench_run *run, kernel_fn kernel, int n,
+                               const double *input, const int *flags,
+                               double *output, double *intermediate,
+                               kernel_result *result) {
+    int iterations = n < SWEEP_MIN_ELEMENTS ? SWEEP_MIN_ELEMENTS / n : 1;
+    volatile double acc = 0.0;
+
+    bench_begin(run, (double)iterations * n);
+    while (bench_next(run)) {
+        for (int iter = 0; iter < iterations; iter++) {
+            kernel(n, input, flags, output, intermediate, result);
+            acc += result->sum;
+        }
+    }
+    bench_end(run);
+    return iterations;
+}
+
+// Times sum over x[0:n], repeated like bench_kernel()
+static inline void bench_sum(bench_run *run, sum_fn sum, const double *x, int n) {
+    int iterations = n < SWEEP_MIN_ELEMENTS ? SWEEP_MIN_ELEMENTS / n : 1;
+    volatile double acc = 0.0;
+
+    bench_begin(run, (double)iterations * n);
+    while (bench_next(run)) {
+        for (int iter = 0; iter < iterations; iter++) {
+            acc += sum(x, n);
+        }
+    }
+    bench_end(run);
+}
+
+// Usage: <program> [--dump FILE] --sweep [N ...]; dump may be NULL
+static inline int bench_sweep(int argc, char **argv, kernel_fn kernel, FILE *dump) {
+    static const int default_sizes[] = { SWEEP_SIZES };
+    int count = argc > 0 ? argc : (int)(sizeof(default_sizes) / sizeof(default_sizes[0]));
+
+    for (int s = 0; s < count; s++) {
+        int n = argc > 0 ? atoi(argv[s]) : default_sizes[s];
+        if (n <= 0) {
+            fprintf(stderr, "bench: invalid size '%s'\n", argv[s]);
+            return 1;
+        }
+
+        double *input = test_alloc(n, sizeof(double));
+        double *output = test_alloc(n, sizeof(double));
+        double *intermediate = test_alloc(n, sizeof(double));
+        int *flags = test_alloc(n, sizeof(int));
+        test_fill(input, flags, n);
+
+        bench_run run;
+        kernel_result result;
+        int iterations = bench_kernel(&run, kernel, n, input, flags,
+                                      output, intermediate, &result);
+
+        char name[32];
+        snprintf(name, sizeof(name), "BENCH_N%d", n);
+        printf("%s_ITERATIONS=%d\n", name, iterations);
+        bench_report(name, &run);
+        printf("SWEEP_COUNT[%d]=%d\n", n, result.count);
+        printf("SWEEP_SUM[%d]=%.17g\n", n, result.sum);
+        printf("SWEEP_SUM2[%d]=%.17g\n", n, result.sum2);
+        if (dump) {
+            snprintf(name, sizeof(name), "SWEEP_OUTPUT_N%d", n);
+            dump_doubles(dump, name, output, n);
+            snprintf(name, sizeof(name), "SWEEP_INTERMEDIATE_N%d", n);
+            dump_doubles(dump, name, intermediate, n);
+        }
+
+        free(input);
+        free(output);
+        free(intermediate);
+        free(flags);
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,134 @@
+/*
+ * In-process benchmark of the Cilk Plus and OpenMP SIMD kernel variants
+ *
+ * Every variant runs against the same input buffers for each size and is
+ * timed with the bench.h harness. Results are written as CSV or JSON, along
+ * with the largest element difference from the first variant and the ISA
+ * clone each variant ran ("default" for kernels built once).
+ *
+ * Build with both variants (kernels_cilk.c needs GCC 7):
+ *   gcc -fopenmp-simd -O2 -c src/kernels_openmp.c
+ *   gcc-7 -fcilkplus -O2 -DHAVE_CILK -o bench_runner src/bench_runner.c \
+ *       src/kernels_cilk.c kernels_openmp.o -lm
+ * Without -DHAVE_CILK only the OpenMP variant is built in.
+ *
+ * Usage: bench_runner [--format csv|json] [N ...]
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "common.h"
+#include "bench.h"
+#include "kernels.h"
+
+typedef struct {
+    const char *name;
+    kernel_fn kernel;
+    const char *compiler;
+    const char *(*isa)(void);  // selected clone of a multiversioned kernel, or NULL
+} kernel_variant;
+
+static const kernel_variant VARIANTS[] = {
+#ifdef HAVE_CILK
+    { "cilk", kernel_cilk, kernel_cilk_compiler, NULL },
+#endif
+    { "openmp", kernel_openmp, kernel_openmp_compiler, kernel_openmp_isa },
+    { "openmp-repro", kernel_openmp_repro, kernel_openmp_compiler, kernel_openmp_isa },
+};
+
+#define NUM_VARIANTS ((int)(sizeof(VARIANTS) / sizeof(VARIANTS[0])))
+
+static double max_abs_diff(const double *a, const double *b, int n) {
+    double worst = 0.0;
+    for (int i = 0; i < n; i++) {
+        double d = fabs(a[i] - b[i]);
+        if (d > worst) worst = d;
+    }
+    return worst;
+}
+
+int main(int argc, char **argv) {
+    static const int default_sizes[] = { SWEEP_SIZES };
+    int json = 0;
+    int first = 1;
+
+    if (argc > 2 && strcmp(argv[1], "--format") == 0) {
+        if (strcmp(argv[2], "json") == 0) {
+            json = 1;
+        } else if (strcmp(argv[2], "csv") != 0) {
+            fprintf(stderr, "Usage: %s [--format csv|json] [N ...]\n", argv[0]);
+            return 1;
+        }
+        argc -= 2;
+        argv += 2;
+    }
+    int num_sizes = argc > 1 ? argc - 1 : (int)(sizeof(default_sizes) / sizeof(default_sizes[0]));
+
+    if (json) {
+        printf("[\n");
+    } else {
+        printf("variant,compiler,isa,n,iterations,reps,min_ns,median_ns,p99_ns,"
+               "melem_per_s,count,sum,sum2,max_abs_diff\n");
+    }
+
+    for (int s = 0; s < num_sizes; s++) {
+        int n = argc > 1 ? atoi(argv[s + 1]) : default_sizes[s];
+        if (n <= 0) {
+            fprintf(stderr, "bench_runner: invalid size '%s'\n", argv[s + 1]);
+            return 1;
+        }
+
+        double *input = test_alloc(n, sizeof(double));
+        int *flags = test_alloc(n, sizeof(int));
+        double *output = test_alloc(n, sizeof(double));
+        double *intermediate = test_alloc(n, sizeof(double));
+        double *ref_output = test_alloc(n, sizeof(double));
+        double *ref_intermediate = test_alloc(n, sizeof(double));
+        test_fill(input, flags, n);
+
+        for (int v = 0; v < NUM_VARIANTS; v++) {
+            bench_run run;
+            kernel_result result;
+            int iterations = bench_kernel(&run, VARIANTS[v].kernel, n, input, flags,
+                                          output, intermediate, &result);
+
+            if (v == 0) {
+                memcpy(ref_output, output, sizeof(double) * n);
+                memcpy(ref_intermediate, intermediate, sizeof(double) * n);
+            }
+            double diff = fmax(max_abs_diff(output, ref_output, n),
+                               max_abs_diff(intermediate, ref_intermediate, n));
+            const char *isa = VARIANTS[v].isa ? VARIANTS[v].isa() : "default";
+
+            if (json) {
+                printf("%s  {\"variant\": \"%s\", \"compiler\": \"%s\", \"isa\": \"%s\", \"n\": %d, "
+                       "\"iterations\": %d, \"reps\": %d, \"min_ns\": %.4f, "
+                       "\"median_ns\": %.4f, \"p99_ns\": %.4f, \"melem_per_s\": %.2f, "
+                       "\"count\": %d, \"sum\": %.17g, \"sum2\": %.17g, "
+                       "\"max_abs_diff\": %.3g}",
+                       first ? "" : ",\n", VARIANTS[v].name, VARIANTS[v].compiler, isa, n,
+                       iterations, run.reps, run.min_ns, run.median_ns, run.p99_ns,
+                       1e3 / run.median_ns, result.count, result.sum, result.sum2, diff);
+            } else {
+                printf("%s,\"%s\",%s,%d,%d,%d,%.4f,%.4f,%.4f,%.2f,%d,%.17g,%.17g,%.3g\n",
+                       VARIANTS[v].name, VARIANTS[v].compiler, isa, n, iterations, run.reps,
+                       run.min_ns, run.median_ns, run.p99_ns, 1e3 / run.median_ns,
+                       result.count, result.sum, result.sum2, diff);
+            }
+            first = 0;
+        }
+
+        free(input);
+        free(flags);
+        free(output);
+        free(intermediate);
+        free(ref_output);
+        free(ref_intermediate);
+    }
+
+    if (json) {
+        printf("\n]\n");
+    }
+    return 0;
+}
@@ -0,0 +1,33 @@
+/*
+ * Cilk Plus section temporaries test: a diffusion step with VLA scratch
+ * Requires: GCC 7.x with -fcilkplus flag
+ *
+ * flux and spread are the kind of temporaries Cilk code declares as VLAs
+ * next to its sections: runtime length, live across statements of different
+ * extents. temporaries.h checks the step's output and times it per element;
+ * openmp_arena_test.c times the same step with its scratch from the stack,
+ * malloc and arena.h.
+ *
+ * Usage: cilk_arena_test [N ...]   sizes, default TEMPS_SIZES
+ */
+
+#include <stdio.h>
+#include "common.h"
+#include "temporaries.h"
+
+static void step(const double *in, double *out, int n) {
+    double flux[n];
+    double spread[n];
+
+    flux[0:n] = in[0:n] * (1.0 - in[0:n]);
+    spread[0:n] = 0.5 * flux[0:n];
+    // Half of each flux goes to the neighbours, a quarter each way
+    spread[1:n - 1] += 0.25 * flux[0:n - 1];
+    spread[0:n - 1] += 0.25 * flux[1:n - 1];
+    out[0:n] = in[0:n] + TEMPS_DT * (spread[0:n] - flux[0:n]);
+}
+
+int main(int argc, char **argv) {
+    static const temps_variant variants[] = {{"STEP", step}};
+    return temps_main(argc - 1, argv + 1, variants, 1);
+}
@@ -0,0 +1,37 @@
+/*
+ * Cilk Plus stream compaction test: packing the alive particles of a batch
+ * Requires: GCC 7.x with -fcilkplus flag
+ *
+ * The pack is written the way MCsquare removes dead particles: a masked
+ * append of __sec_implicit_index collects the indices of the alive ones,
+ * then one gather section per field copies them into the other buffer.
+ * compact.h times it against the scalar branchy loop and checks that both
+ * produce the same batch.
+ *
+ * Usage: cilk_compact_test [N ...]   batch sizes, default PARTICLE_BATCH
+ */
+
+#include <stdio.h>
+#include "common.h"
+#include "compact.h"
+
+static int pack_soa(particle_batch *in, particle_batch *out, int *keep) {
+    int n = in->n;
+    int *alive = in->alive;
+    int kept = 0;
+
+    if (alive[0:n]) {
+        keep[kept++] = __sec_implicit_index(0);
+    }
+    for (int f = 0; f < PT_FIELDS; f++) {
+        double *src = in->field[f], *dst = out->field[f];
+        dst[0:kept] = src[keep[0:kept]];
+    }
+    out->alive[0:kept] = 1;
+    out->n = kept;
+    return kept;
+}
+
+int main(int argc, char **argv) {
+    return compact_main(argc - 1, argv + 1, pack_soa);
+}
@@ -0,0 +1,98 @@
+/*
+ * Cilk Plus particle transport test: SoA and AoS batches
+ * Requires: GCC 7.x with -fcilkplus flag
+ *
+ * Every step updates energy, direction, position and weight of a whole
+ * particle batch under its alive mask (particles.h), in two layouts:
+ * 1. SoA: unit-stride sections of one array per field
+ * 2. AoS: strided sections [f:n:PT_FIELDS] of 64-byte particle records
+ *
+ * Usage: cilk_particles_test [N ...]   batch sizes, default PARTICLE_BATCH
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include "common.h"
+
+#define BENCH_REPS 21  // each sample transports a whole batch to the end
+#include "particles.h"
+
+static void step_soa(particle_batch *b, particle_tally *t) {
+    int n = b->n;
+    double *x = b->field[PT_X], *y = b->field[PT_Y], *z = b->field[PT_Z];
+    double *u = b->field[PT_U], *v = b->field[PT_V], *w = b->field[PT_W];
+    double *energy = b->field[PT_ENERGY], *weight = b->field[PT_WEIGHT];
+    double *step = b->step, *loss = b->loss, *turn = b->turn, *next_u = b->next_u;
+    int *units = b->units;
+    int *alive = b->alive;
+
+    // turn is tan(deflection / 2); (u, w) rotate by the deflection exactly
+    if (alive[0:n]) {
+        step[0:n] = PT_STEP * (energy[0:n] + 1.0) / (energy[0:n] + PT_E0);
+        loss[0:n] = energy[0:n] * (1.0 - exp(-(z[0:n] < PT_SLAB ? PT_LOSS_WATER : PT_LOSS_AIR) *
+                                             step[0:n] / (energy[0:n] + 1.0)));
+        turn[0:n] = (z[0:n] < PT_SLAB ? PT_SCATTER : 0.0) * step[0:n] / (energy[0:n] + 1.0);
+        energy[0:n] -= loss[0:n];
+        next_u[0:n] = (u[0:n] * (1.0 - turn[0:n] * turn[0:n]) - 2.0 * w[0:n] * turn[0:n]) /
+                      (1.0 + turn[0:n] * turn[0:n]);
+        w[0:n] = (w[0:n] * (1.0 - turn[0:n] * turn[0:n]) + 2.0 * u[0:n] * turn[0:n]) /
+                 (1.0 + turn[0:n] * turn[0:n]);
+        u[0:n] = next_u[0:n];
+        x[0:n] += u[0:n] * step[0:n];
+        y[0:n] += v[0:n] * step[0:n];
+        z[0:n] += w[0:n] * step[0:n];
+        weight[0:n] *= exp(-PT_ATTENUATION * step[0:n]);
+        // A particle that stops deposits what it has left
+        units[0:n] = (int)((loss[0:n] + (energy[0:n] <= PT_CUTOFF ? energy[0:n] : 0.0)) *
+                                 weight[0:n] * DOSE_SCALE);
+    } else {
+        units[0:n] = 0;
+    }
+    alive[0:n] = alive[0:n] && energy[0:n] > PT_CUTOFF && z[0:n] >= 0.0 && z[0:n] < PT_DEPTH &&
+                 fabs(x[0:n]) < PT_WIDTH && fabs(y[0:n]) < PT_WIDTH;
+
+    long long deposited = __sec_reduce_add((long long)units[0:n]);
+    t->dose += deposited;
+}
+
+static void step_aos(particle_batch *b, particle_tally *t) {
+    int n = b->n;
+    double *r = b->records;
+    double *step = b->step, *loss = b->loss, *turn = b->turn, *next_u = b->next_u;
+    int *units = b->units;
+    int *alive = b->alive;
+
+    if (alive[0:n]) {
+        step[0:n] = PT_STEP * (r[PT_ENERGY:n:PT_FIELDS] + 1.0) / (r[PT_ENERGY:n:PT_FIELDS] + PT_E0);
+        loss[0:n] = r[PT_ENERGY:n:PT_FIELDS] *
+                    (1.0 - exp(-(r[PT_Z:n:PT_FIELDS] < PT_SLAB ? PT_LOSS_WATER : PT_LOSS_AIR) *
+                               step[0:n] / (r[PT_ENERGY:n:PT_FIELDS] + 1.0)));
+        turn[0:n] = (r[PT_Z:n:PT_FIELDS] < PT_SLAB ? PT_SCATTER : 0.0) * step[0:n] /
+                    (r[PT_ENERGY:n:PT_FIELDS] + 1.0);
+        r[PT_ENERGY:n:PT_FIELDS] -= loss[0:n];
+        next_u[0:n] = (r[PT_U:n:PT_FIELDS] * (1.0 - turn[0:n] * turn[0:n]) -
+                       2.0 * r[PT_W:n:PT_FIELDS] * turn[0:n]) / (1.0 + turn[0:n] * turn[0:n]);
+        r[PT_W:n:PT_FIELDS] = (r[PT_W:n:PT_FIELDS] * (1.0 - turn[0:n] * turn[0:n]) +
+                               2.0 * r[PT_U:n:PT_FIELDS] * turn[0:n]) / (1.0 + turn[0:n] * turn[0:n]);
+        r[PT_U:n:PT_FIELDS] = next_u[0:n];
+        r[PT_X:n:PT_FIELDS] += r[PT_U:n:PT_FIELDS] * step[0:n];
+        r[PT_Y:n:PT_FIELDS] += r[PT_V:n:PT_FIELDS] * step[0:n];
+        r[PT_Z:n:PT_FIELDS] += r[PT_W:n:PT_FIELDS] * step[0:n];
+        r[PT_WEIGHT:n:PT_FIELDS] *= exp(-PT_ATTENUATION * step[0:n]);
+        units[0:n] = (int)((loss[0:n] + (r[PT_ENERGY:n:PT_FIELDS] <= PT_CUTOFF ?
+                                               r[PT_ENERGY:n:PT_FIELDS] : 0.0)) *
+                                 r[PT_WEIGHT:n:PT_FIELDS] * DOSE_SCALE);
+    } else {
+        units[0:n] = 0;
+    }
+    alive[0:n] = alive[0:n] && r[PT_ENERGY:n:PT_FIELDS] > PT_CUTOFF &&
+                 r[PT_Z:n:PT_FIELDS] >= 0.0 && r[PT_Z:n:PT_FIELDS] < PT_DEPTH &&
+                 fabs(r[PT_X:n:PT_FIELDS]) < PT_WIDTH && fabs(r[PT_Y:n:PT_FIELDS]) < PT_WIDTH;
+
+    long long deposited = __sec_reduce_add((long long)units[0:n]);
+    t->dose += deposited;
+}
+
+int main(int argc, char **argv) {
+    return particles_main(argc - 1, argv + 1, step_soa, step_aos);
+}
@@ -0,0 +1,103 @@
+/*
+ * Cilk Plus reducer test
+ * Requires: GCC 7.x with -fcilkplus flag
+ *
+ * Tests the reducer hyperobjects used for parallel dose accumulation:
+ * 1. Built-in reducers: CILK_C_REDUCER_OPADD total, CILK_C_REDUCER_MAX peak
+ * 2. Custom reducer: a dose grid merged voxel by voxel
+ *
+ * Deposits are fixed point, so every sample must reproduce the first one
+ * exactly whatever the steal pattern. The worker count follows CILK_NWORKERS.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <cilk/reducer.h>
+#include <cilk/reducer_opadd.h>
+#include <cilk/reducer_max.h>
+#include "common.h"
+
+#define BENCH_REPS 21  // each sample deposits all NUM_PARTICLES particles
+#include "bench.h"
+
+static void dose_reduce(void *key, void *left, void *right) {
+    (void)key;
+    dose_grid *l = left;
+    const dose_grid *r = right;
+    for (int v = 0; v < DOSE_VOXELS; v++) {
+        l->voxels[v] += r->voxels[v];
+    }
+}
+
+static void dose_identity(void *key, void *view) {
+    (void)key;
+    memset(view, 0, sizeof(dose_grid));
+}
+
+static void dose_destroy(void *key, void *view) {
+    (void)key;
+    (void)view;
+}
+
+int main(void) {
+    CILK_C_REDUCER_OPADD(total, longlong, 0);
+    CILK_C_REDUCER_MAX(peak, longlong, 0);
+    CILK_C_DECLARE_REDUCER(dose_grid) grid =
+        CILK_C_INIT_REDUCER(dose_grid, dose_reduce, dose_identity, dose_destroy, {{0}});
+    CILK_C_REGISTER_REDUCER(total);
+    CILK_C_REGISTER_REDUCER(peak);
+    CILK_C_REGISTER_REDUCER(grid);
+
+    dose_grid first;
+    long long first_total = 0;
+    int deterministic = 1;
+
+    // Pattern E: contended accumulation into reducer views
+    bench_run run;
+    bench_begin(&run, NUM_PARTICLES);
+    while (bench_next(&run)) {
+        REDUCER_VIEW(total) = 0;
+        REDUCER_VIEW(peak) = 0;
+        memset(&REDUCER_VIEW(grid), 0, sizeof(dose_grid));
+
+        _Cilk_for (int p = 0; p < NUM_PARTICLES; p++) {
+            long long deposited = dose_particle(p, REDUCER_VIEW(grid).voxels);
+            REDUCER_VIEW(total) += deposited;
+            CILK_C_REDUCER_MAX_CALC(peak, longlong, deposited);
+        }
+
+        if (run.index == 1) {
+            first = REDUCER_VIEW(grid);
+            first_total = REDUCER_VIEW(total);
+        } else if (REDUCER_VIEW(total) != first_total ||
+                   memcmp(&first, &REDUCER_VIEW(grid), sizeof(dose_grid)) != 0) {
+            deterministic = 0;
+        }
+    }
+    bench_end(&run);
+
+    CILK_C_UNREGISTER_REDUCER(total);
+    CILK_C_UNREGISTER_REDUCER(peak);
+    CILK_C_UNREGISTER_REDUCER(grid);
+
+    long long voxel_sum = 0;
+    for (int v = 0; v < DOSE_VOXELS; v++) {
+        voxel_sum += grid.value.voxels[v];
+    }
+
+    // Timing first
+    printf("TIMING_MS=%.3f\n", run.total_ms);
+    bench_report("BENCH", &run);
+
+    printf("NUM_PARTICLES=%d\n", NUM_PARTICLES);
+    printf("DETERMINISTIC=%d\n", deterministic);
+    printf("DOSE_TOTAL=%lld\n", total.value);
+    printf("DOSE_PEAK=%lld\n", peak.value);
+    printf("DOSE_VOXEL_SUM=%lld\n", voxel_sum);
+
+    for (int v = 0; v < DOSE_VOXELS; v++) {
+        printf("DOSE[%d]=%lld\n", v, grid.value.voxels[v]);
+    }
+
+    return 0;
+}
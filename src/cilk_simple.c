@@ -32,14 +32,14 @@ int main(void) {
 
     printf("VLENGTH=%d\n", VLENGTH);
     printf("REDUCTION_COUNT=%d\n", count);
-    printf("REDUCTION_SUM=%.15g\n", sum);
-    printf("REDUCTION_SUM2=%.15g\n", sum2);
+    printf("REDUCTION_SUM=%.17g\n", sum);
+    printf("REDUCTION_SUM2=%.17g\n", sum2);
 
     for (int i = 0; i < VLENGTH; i++) {
-        printf("OUTPUT[%d]=%.15g\n", i, output[i]);
+        printf("OUTPUT[%d]=%.17g\n", i, output[i]);
     }
     for (int i = 0; i < VLENGTH; i++) {
-        printf("INTERMEDIATE[%d]=%.15g\n", i, intermediate[i]);
+        printf("INTERMEDIATE[%d]=%.17g\n", i, intermediate[i]);
     }
 
     return 0;
@@ -0,0 +1,75 @@
+/*
+ * Cilk Plus task parallelism test
+ * Requires: GCC 7.x with -fcilkplus flag
+ *
+ * Tests the Cilk Plus task constructs used for per-particle batches:
+ * 1. Parallel loop: _Cilk_for over batches of uneven cost
+ * 2. Fork-join recursion: _Cilk_spawn / _Cilk_sync
+ *
+ * The worker count follows CILK_NWORKERS.
+ */
+
+#include <stdio.h>
+#include "common.h"
+
+#define BENCH_REPS 21  // each sample runs all NUM_BATCHES batches
+#include "bench.h"
+
+// Pattern D: divide and conquer over batches, combined in a fixed order
+static double range_sum(int lo, int hi) {
+    if (hi - lo <= TASK_GRAIN) {
+        double sum = 0.0;
+        for (int b = lo; b < hi; b++) {
+            sum += task_batch_work(b);
+        }
+        return sum;
+    }
+    int mid = lo + (hi - lo) / 2;
+    double left = _Cilk_spawn range_sum(lo, mid);
+    double right = range_sum(mid, hi);
+    _Cilk_sync;
+    return left + right;
+}
+
+int main(void) {
+    double results[NUM_BATCHES];
+    double spawn_sum = 0.0;
+
+    // Pattern C: parallel loop over batches, balanced by work stealing
+    bench_run run_for;
+    bench_begin(&run_for, NUM_BATCHES);
+    while (bench_next(&run_for)) {
+        _Cilk_for (int b = 0; b < NUM_BATCHES; b++) {
+            results[b] = task_batch_work(b);
+        }
+    }
+    bench_end(&run_for);
+
+    bench_run run_spawn;
+    bench_begin(&run_spawn, NUM_BATCHES);
+    while (bench_next(&run_spawn)) {
+        spawn_sum = range_sum(0, NUM_BATCHES);
+    }
+    bench_end(&run_spawn);
+
+    double for_sum = 0.0;
+    for (int b = 0; b < NUM_BATCHES; b++) {
+        for_sum += results[b];
+    }
+
+    // Timing first
+    printf("TIMING_FOR_MS=%.3f\n", run_for.total_ms);
+    printf("TIMING_SPAWN_MS=%.3f\n", run_spawn.total_ms);
+    bench_report("BENCH_FOR", &run_for);
+    bench_report("BENCH_SPAWN", &run_spawn);
+
+    printf("NUM_BATCHES=%d\n", NUM_BATCHES);
+    printf("FOR_SUM=%.17g\n", for_sum);
+    printf("SPAWN_SUM=%.17g\n", spawn_sum);
+
+    for (int b = 0; b < NUM_BATCHES; b++) {
+        printf("BATCH[%d]=%.17g\n", b, results[b]);
+    }
+
+    return 0;
+}
@@ -4,18 +4,35 @@
  *
  * Tests the two main Cilk Plus patterns used in MCsquare:
  * 1. Array section notation: a[0:N] = expr(b[0:N])
- * 2. Reduction built-in: __sec_reduce_add()
+ * 2. Reduction built-ins: __sec_reduce_add() and the max/min/mul/_ind/
+ *    any_nonzero/all_zero family
+ * 3. Strided and offset sections: a[start:len:stride]
+ * 4. Masked conditionals: if (a[0:N] > x) { ... } else { ... }
+ * 5. Single-use temporaries: a section written only to be reduced
  */
 
 #include <stdio.h>
 #include <math.h>
-#include <time.h>
+#include <string.h>
 #include "common.h"
+#include "bench.h"
+#include "dump.h"
+#include "kernels.h"
+#include "perfcount.h"
 
 #define vALL 0:VLENGTH  // MCsquare-style macro
 #define ITERATIONS 100
+#define PERF_ITERATIONS 10000  // repetitions of each block under the counters
+
+int main(int argc, char **argv) {
+    // --dump FILE writes the arrays to a binary dump (dump.h) instead of printing them
+    FILE *dump = dump_option(&argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--sweep") == 0) {
+        int status = bench_sweep(argc - 2, argv + 2, kernel_cilk, dump);
+        if (dump) dump_close(dump);
+        return status;
+    }
 
-int main(void) {
     double input[VLENGTH];
     double output[VLENGTH];
     double intermediate[VLENGTH];
@@ -32,48 +49,163 @@ int main(void) {
         flags[i] = TEST_FLAGS[i];
     }
 
-    clock_t start = clock();
+    bench_run run;
+    bench_begin(&run, (double)ITERATIONS * VLENGTH);
+
+    while (bench_next(&run)) {
+        for (int iter = 0; iter < ITERATIONS; iter++) {
+            // Pattern A: Array section with transcendental (like MCsquare physics)
+            output[vALL] = -log(input[vALL]) * 2.0;
+
+            // Pattern A2: Chained operations (like v_step calculation)
+            intermediate[vALL] = exp(-input[vALL]) / (input[vALL] + 0.1);
+
+            // Pattern B: Reduction (like particle counting)
+            int count = __sec_reduce_add(flags[vALL]);
+            double sum = __sec_reduce_add(output[vALL]);
+            double sum2 = __sec_reduce_add(intermediate[vALL]);
+
+            // Accumulate to prevent optimization
+            acc_sum += sum;
+            acc_sum2 += sum2;
+            acc_count += count;
+        }
+    }
+
+    bench_end(&run);
+
+#ifdef PERF_COUNTERS
+    // Each pattern block again under hardware counters (perfcount.h), after the
+    // timed samples so they carry no counter overhead
+    perfcount_group perf;
+    perfcount_sample perf_a, perf_a2, perf_b;
+    perfcount_open(&perf);
 
-    for (int iter = 0; iter < ITERATIONS; iter++) {
-        // Pattern A: Array section with transcendental (like MCsquare physics)
+    perfcount_start(&perf);
+    for (int iter = 0; iter < PERF_ITERATIONS; iter++) {
         output[vALL] = -log(input[vALL]) * 2.0;
+    }
+    perfcount_stop(&perf, &perf_a, (double)PERF_ITERATIONS * VLENGTH);
 
-        // Pattern A2: Chained operations (like v_step calculation)
+    perfcount_start(&perf);
+    for (int iter = 0; iter < PERF_ITERATIONS; iter++) {
         intermediate[vALL] = exp(-input[vALL]) / (input[vALL] + 0.1);
+    }
+    perfcount_stop(&perf, &perf_a2, (double)PERF_ITERATIONS * VLENGTH);
 
-        // Pattern B: Reduction (like particle counting)
+    perfcount_start(&perf);
+    for (int iter = 0; iter < PERF_ITERATIONS; iter++) {
         int count = __sec_reduce_add(flags[vALL]);
         double sum = __sec_reduce_add(output[vALL]);
         double sum2 = __sec_reduce_add(intermediate[vALL]);
 
-        // Accumulate to prevent optimization
         acc_sum += sum;
         acc_sum2 += sum2;
         acc_count += count;
     }
-
-    clock_t end = clock();
-    double elapsed_ms = (double)(end - start) / CLOCKS_PER_SEC * 1000.0;
+    perfcount_stop(&perf, &perf_b, (double)PERF_ITERATIONS * VLENGTH);
+#endif
 
     // Timing first
-    printf("TIMING_MS=%.3f\n", elapsed_ms);
+    printf("TIMING_MS=%.3f\n", run.total_ms);
     printf("ITERATIONS=%d\n", ITERATIONS);
+    bench_report("BENCH", &run);
+#ifdef PERF_COUNTERS
+    perfcount_status(&perf);
+    perfcount_report("PERF_A", &perf_a);
+    perfcount_report("PERF_A2", &perf_a2);
+    perfcount_report("PERF_B", &perf_b);
+    perfcount_close(&perf);
+#endif
 
     // Results from last iteration
     int count = __sec_reduce_add(flags[vALL]);
     double sum = __sec_reduce_add(output[vALL]);
     double sum2 = __sec_reduce_add(intermediate[vALL]);
 
+    // Pattern B2: Other reduction built-ins (extrema, product, flag tests)
+    double max_out = __sec_reduce_max(output[vALL]);
+    double min_out = __sec_reduce_min(output[vALL]);
+    double prod = __sec_reduce_mul(input[vALL]);
+    int max_ind = __sec_reduce_max_ind(intermediate[vALL]);
+    int min_ind = __sec_reduce_min_ind(intermediate[vALL]);
+    int any_flag = __sec_reduce_any_nonzero(flags[vALL]);
+    int no_flags = __sec_reduce_all_zero(flags[vALL]);
+
+    // All-NaN section: no comparison succeeds, the index is still the first element's
+    double undefined[VLENGTH];
+    undefined[vALL] = NAN;
+    int nan_max_ind = __sec_reduce_max_ind(undefined[vALL]);
+    int nan_min_ind = __sec_reduce_min_ind(undefined[vALL]);
+
+    // Pattern C: Strided and offset sections (interleaved particle records)
+    int stride = 3;  // x, y, z per record
+    double records[3 * VLENGTH];
+    double path[VLENGTH];
+    records[0:VLENGTH:stride] = input[vALL];
+    records[1:VLENGTH:stride] = input[vALL] * 2.0;
+    records[2:VLENGTH:3] = intermediate[vALL];
+    path[vALL] = records[0:VLENGTH:stride] + records[1:VLENGTH:stride] * records[2:VLENGTH:3];
+    double tail_sum = __sec_reduce_add(output[2:VLENGTH - 2]);
+
+    // Pattern D: Masked conditionals (like stopping low-energy particles)
+    double weight[VLENGTH];
+    double deposit[VLENGTH];
+    if (input[vALL] > 0.45) {
+        weight[vALL] = exp(-input[vALL]);
+        deposit[vALL] = weight[vALL] * output[vALL];
+    } else {
+        weight[vALL] = 0.0;
+        deposit[vALL] = input[vALL] * 0.5;
+    }
+    if (flags[vALL]) {
+        deposit[vALL] += intermediate[vALL];
+    }
+
+    // Pattern E: Single-use temporary (energy loss only needed for the dose)
+    double loss[VLENGTH];
+    loss[vALL] = input[vALL] * (1.0 + intermediate[vALL]);
+    double dose = __sec_reduce_add(loss[vALL] * weight[vALL]);
+
     printf("VLENGTH=%d\n", VLENGTH);
     printf("REDUCTION_COUNT=%d\n", count);
-    printf("REDUCTION_SUM=%.15g\n", sum);
-    printf("REDUCTION_SUM2=%.15g\n", sum2);
-
-    for (int i = 0; i < VLENGTH; i++) {
-        printf("OUTPUT[%d]=%.15g\n", i, output[i]);
-    }
-    for (int i = 0; i < VLENGTH; i++) {
-        printf("INTERMEDIATE[%d]=%.15g\n", i, intermediate[i]);
+    printf("REDUCTION_SUM=%.17g\n", sum);
+    printf("REDUCTION_SUM2=%.17g\n", sum2);
+    printf("REDUCTION_MAX=%.17g\n", max_out);
+    printf("REDUCTION_MIN=%.17g\n", min_out);
+    printf("REDUCTION_MUL=%.17g\n", prod);
+    printf("REDUCTION_MAX_IND=%d\n", max_ind);
+    printf("REDUCTION_MIN_IND=%d\n", min_ind);
+    printf("REDUCTION_NAN_MAX_IND=%d\n", nan_max_ind);
+    printf("REDUCTION_NAN_MIN_IND=%d\n", nan_min_ind);
+    printf("REDUCTION_ANY_NONZERO=%d\n", any_flag);
+    printf("REDUCTION_ALL_ZERO=%d\n", no_flags);
+    printf("REDUCTION_TAIL_SUM=%.17g\n", tail_sum);
+    printf("REDUCTION_DOSE=%.17g\n", dose);
+
+    if (dump) {
+        dump_doubles(dump, "OUTPUT", output, VLENGTH);
+        dump_doubles(dump, "INTERMEDIATE", intermediate, VLENGTH);
+        dump_doubles(dump, "PATH", path, VLENGTH);
+        dump_doubles(dump, "WEIGHT", weight, VLENGTH);
+        dump_doubles(dump, "DEPOSIT", deposit, VLENGTH);
+        dump_close(dump);
+    } else {
+        for (int i = 0; i < VLENGTH; i++) {
+            printf("OUTPUT[%d]=%.17g\n", i, output[i]);
+        }
+        for (int i = 0; i < VLENGTH; i++) {
+            printf("INTERMEDIATE[%d]=%.17g\n", i, intermediate[i]);
+        }
+        for (int i = 0; i < VLENGTH; i++) {
+            printf("PATH[%d]=%.17g\n", i, path[i]);
+        }
+        for (int i = 0; i < VLENGTH; i++) {
+            printf("WEIGHT[%d]=%.17g\n", i, weight[i]);
+        }
+        for (int i = 0; i < VLENGTH; i++) {
+            printf("DEPOSIT[%d]=%.17g\n", i, deposit[i]);
+        }
     }
 
     return 0;
@@ -1,15 +1,102 @@
 #ifndef COMMON_H
 #define COMMON_H
 
-#define VLENGTH 8  // Match MCsquare's typical SIMD width
+#include <stdio.h>
+#include <stdlib.h>
 
-// Deterministic test data for reproducibility
-static const double TEST_INPUT[VLENGTH] = {
-    0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8
+// Match MCsquare's typical SIMD width; -DVLENGTH=4 or 16 builds the tests
+// at another compile-time width (up to TEST_TABLE_LENGTH)
+#ifndef VLENGTH
+#define VLENGTH 8
+#endif
+
+// Deterministic test data for reproducibility; the first 8 entries are the
+// data of the default width
+#define TEST_TABLE_LENGTH 16
+
+_Static_assert(VLENGTH > 0 && VLENGTH <= TEST_TABLE_LENGTH, "VLENGTH must be 1..TEST_TABLE_LENGTH");
+
+static const double TEST_INPUT[TEST_TABLE_LENGTH] = {
+    0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8,
+    0.9, 1.0, 1.1, 1.2, 1.3, 1.4, 1.5, 1.6
 };
 
-static const int TEST_FLAGS[VLENGTH] = {
-    1, 0, 1, 1, 0, 0, 1, 1
+static const int TEST_FLAGS[TEST_TABLE_LENGTH] = {
+    1, 0, 1, 1, 0, 0, 1, 1,
+    0, 1, 1, 0, 1, 0, 0, 1
 };
 
+// Problem sizes for --sweep: from L1-resident up to well past the LLC
+#ifndef SWEEP_SIZES
+#define SWEEP_SIZES 8, 64, 512, 4096, 32768, 262144, 2097152
+#endif
+
+#define TEST_ALIGN 64
+
+// 64-byte aligned heap buffer; aligned_alloc needs a multiple of the alignment
+static inline void *test_alloc(size_t count, size_t size) {
+    size_t bytes = (count * size + TEST_ALIGN - 1) / TEST_ALIGN * TEST_ALIGN;
+    void *p = aligned_alloc(TEST_ALIGN, bytes);
+    if (!p) {
+        fprintf(stderr, "cannot allocate %zu bytes\n", bytes);
+        exit(1);
+    }
+    return p;
+}
+
+// Elements lo..hi-1 of test_fill(), so threads can each fill their own part
+static inline void test_fill_range(double *input, int *flags, size_t lo, size_t hi) {
+    for (size_t i = lo; i < hi; i++) {
+        input[i] = TEST_INPUT[i % VLENGTH] + 1e-3 * (double)((i / VLENGTH) % 97);
+        flags[i] = TEST_FLAGS[i % VLENGTH];
+    }
+}
+
+// Deterministic inputs of any length; the first VLENGTH match the tables above
+static inline void test_fill(double *input, int *flags, size_t n) {
+    test_fill_range(input, flags, 0, n);
+}
+
+// Per-particle batches for the task-parallel tests; cost varies 16x between
+// batches so load balance matters
+#define NUM_BATCHES 256
+#define TASK_GRAIN 8  // batches summed serially at the leaves of range_sum()
+
+static inline double task_batch_work(int batch) {
+    int steps = 200 + (batch % 16) * 400;
+    double energy = TEST_INPUT[batch % VLENGTH];
+    for (int s = 0; s < steps; s++) {
+        energy = energy * (1.0 - 1e-3 * energy) + 1e-4 * TEST_FLAGS[s % VLENGTH];
+    }
+    return energy;
+}
+
+// Dose accumulation through reducers: each particle deposits along a track
+// of DOSE_STEPS voxels. Deposits are counted in fixed-point units of
+// 1/DOSE_SCALE, so integer sums are bit-identical in any combine order.
+#define NUM_PARTICLES 20000
+#define DOSE_VOXELS 64
+#define DOSE_STEPS 64
+#define DOSE_SCALE 1e9
+
+typedef struct {
+    long long voxels[DOSE_VOXELS];
+} dose_grid;
+
+// Deposits one particle into voxels; returns its total deposit
+static inline long long dose_particle(int particle, long long *voxels) {
+    double energy = 1.0 + TEST_INPUT[particle % VLENGTH];
+    unsigned voxel = (unsigned)particle * 2654435761u % DOSE_VOXELS;
+    long long total = 0;
+    for (int s = 0; s < DOSE_STEPS; s++) {
+        double deposit = energy * (0.02 + 0.01 * TEST_FLAGS[(particle + s) % VLENGTH]);
+        long long units = (long long)(deposit * DOSE_SCALE);
+        energy -= deposit;
+        voxels[voxel] += units;
+        total += units;
+        voxel = (voxel * 5 + 1) % DOSE_VOXELS;
+    }
+    return total;
+}
+
 #endif
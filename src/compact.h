@@ -0,0 +1,145 @@
+#ifndef COMPACT_H
+#define COMPACT_H
+
+/*
+ * Stream compaction of particle batches, for the pack tests.
+ *
+ * Removing dead particles copies the alive ones, in order, to the front of a
+ * second SoA batch (particles.h). The obvious loop branches on the mask and
+ * bumps a counter, which makes every iteration depend on the one before:
+ *
+ *     for (i = 0; i < n; i++) if (alive[i]) out[kept++] = in[i];
+ *
+ * The tests instead pack the indices of the alive particles, the Cilk test
+ * with array notation and __sec_implicit_index, the OpenMP one with the
+ * exclusive-scan loop the converter lowers that to, and then gather each
+ * field through them. compact_scalar() is the branchy loop above, the
+ * reference for both. Packing copies doubles unchanged, so every pack must
+ * match it bit for bit.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "common.h"
+#include "bench.h"
+#include "particles.h"
+
+// Percentages of the batch left alive
+#ifndef COMPACT_RATES
+#define COMPACT_RATES 10, 50, 90
+#endif
+
+// Packs the alive particles of in into out (capacity in->n); returns the count
+typedef int (*compact_fn)(particle_batch *in, particle_batch *out, int *keep);
+
+static inline int compact_scalar(particle_batch *in, particle_batch *out, int *keep) {
+    (void)keep;
+    int kept = 0;
+    for (int i = 0; i < in->n; i++) {
+        if (in->alive[i]) {
+            for (int f = 0; f < PT_FIELDS; f++) {
+                out->field[f][kept] = in->field[f][i];
+            }
+            out->alive[kept] = 1;
+            kept++;
+        }
+    }
+    out->n = kept;
+    return kept;
+}
+
+// Deterministic mask with about rate% alive, in runs and isolated particles
+static inline void compact_init(particle_batch *b, int n, int rate) {
+    particles_init(b, n);
+    for (int i = 0; i < n; i++) {
+        b->alive[i] = (int)((uint32_t)i * 2654435761u % 100u) < rate;
+    }
+}
+
+// FNV-1a over the bits of the first n particles' fields
+static inline unsigned long long compact_checksum(const particle_batch *b) {
+    unsigned long long h = 14695981039346656037ull;
+    for (int f = 0; f < PT_FIELDS; f++) {
+        for (int i = 0; i < b->n; i++) {
+            uint64_t bits;
+            memcpy(&bits, &b->field[f][i], sizeof(bits));
+            h = (h ^ bits) * 1099511628211ull;
+        }
+    }
+    return h;
+}
+
+static inline int compact_equal(const particle_batch *a, const particle_batch *b) {
+    if (a->n != b->n) {
+        return 0;
+    }
+    for (int f = 0; f < PT_FIELDS; f++) {
+        if (memcmp(a->field[f], b->field[f], sizeof(double) * a->n) != 0) {
+            return 0;
+        }
+    }
+    return memcmp(a->alive, b->alive, sizeof(int) * a->n) == 0;
+}
+
+static inline void compact_time(const char *name, compact_fn pack, particle_batch *in,
+                                particle_batch *out, int *keep) {
+    bench_run run;
+    bench_begin(&run, (double)in->n);
+    while (bench_next(&run)) {
+        pack(in, out, keep);
+    }
+    bench_end(&run);
+    bench_report(name, &run);
+}
+
+// COMPACT_N<n>_R<rate>_{KEPT,CHECKSUM,MATCH} and BENCH_{SCALAR,PACK}_N<n>_R<rate>_*
+// per input particle; MATCH compares pack with compact_scalar
+static inline int compact_benchmark(compact_fn pack, int n, int rate) {
+    particle_batch in, out, ref;
+    int *keep = test_alloc(n, sizeof(int));
+    particles_alloc(&in, n, 0);
+    particles_alloc(&out, n, 0);
+    particles_alloc(&ref, n, 0);
+    compact_init(&in, n, rate);
+
+    compact_scalar(&in, &ref, keep);
+    int kept = pack(&in, &out, keep);
+    int match = compact_equal(&out, &ref);
+
+    char name[48];
+    snprintf(name, sizeof(name), "COMPACT_N%d_R%d", n, rate);
+    printf("%s_KEPT=%d\n", name, kept);
+    printf("%s_CHECKSUM=%llu\n", name, compact_checksum(&out));
+    printf("%s_MATCH=%d\n", name, match);
+
+    snprintf(name, sizeof(name), "BENCH_SCALAR_N%d_R%d", n, rate);
+    compact_time(name, compact_scalar, &in, &ref, keep);
+    snprintf(name, sizeof(name), "BENCH_PACK_N%d_R%d", n, rate);
+    compact_time(name, pack, &in, &out, keep);
+
+    particles_free(&in);
+    particles_free(&out);
+    particles_free(&ref);
+    free(keep);
+    return match;
+}
+
+// Usage: <program> [N ...]; every rate in COMPACT_RATES for each batch size
+static inline int compact_main(int argc, char **argv, compact_fn pack) {
+    static const int rates[] = {COMPACT_RATES};
+    int count = argc > 0 ? argc : 1;
+    int match = 1;
+    for (int s = 0; s < count; s++) {
+        int n = argc > 0 ? atoi(argv[s]) : PARTICLE_BATCH;
+        if (n <= 0) {
+            fprintf(stderr, "compact: invalid batch size '%s'\n", argv[s]);
+            return 1;
+        }
+        for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+            match &= compact_benchmark(pack, n, rates[r]);
+        }
+    }
+    return match ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef DISPATCH_H
+#define DISPATCH_H
+
+/*
+ * Runtime ISA dispatch for kernels built once and run on mixed clusters.
+ *
+ * DISPATCH_CLONES compiles a function for AVX-512F, AVX2 and the baseline
+ * target (GCC/Clang target_clones); the dynamic loader picks one clone
+ * through an ifunc resolver at startup, so a single -O2 binary runs
+ * full-width SIMD on every node:
+ *
+ *     DISPATCH_CLONES
+ *     void kernel(int n, const double *input, double *output) { ... }
+ *
+ * dispatch_isa() names the clone the resolver selects on this CPU. It
+ * repeats the resolver's check (highest supported ISA first), so it can be
+ * reported alongside timings.
+ *
+ * Clones need x86-64 and an ELF target with ifunc support (glibc); elsewhere,
+ * or with -DDISPATCH_DISABLE, DISPATCH_CLONES is empty and every kernel runs
+ * the "default" build. Clones do not define __AVX2__ etc., so code that
+ * selects intrinsics by macro (vec.h) stays at the baseline inside them.
+ */
+
+#if defined(__x86_64__) && defined(__ELF__) && defined(__has_attribute) && !defined(DISPATCH_DISABLE)
+#if __has_attribute(target_clones)
+#define DISPATCH_ENABLED 1
+#endif
+#endif
+
+#ifdef DISPATCH_ENABLED
+#define DISPATCH_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define DISPATCH_CLONES
+#endif
+
+static inline const char *dispatch_isa(void) {
+#ifdef DISPATCH_ENABLED
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return "avx512f";
+    if (__builtin_cpu_supports("avx2")) return "avx2";
+#endif
+    return "default";
+}
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef DUMP_H
+#define DUMP_H
+
+/*
+ * Binary result dumps for compare_outputs.py.
+ *
+ * Formatting every element with %.17g, and parsing it back, dominates
+ * validation time at real sizes. With --dump FILE the test programs write
+ * their arrays here instead of printing them; scalars are still printed.
+ *
+ * The file is DUMP_MAGIC followed by one record per array: a 64-byte header
+ * (NUL-padded name, numpy dtype string, little-endian uint64 length) and the
+ * raw little-endian elements. Every record starts 8-byte aligned, so
+ * compare_outputs.py memory-maps the arrays in place. Element i of NAME is
+ * compared as key NAME[i], exactly as if it had been printed.
+ *
+ *     FILE *dump = dump_option(&argc, argv);
+ *     ...
+ *     dump_doubles(dump, "OUTPUT", output, n);
+ *     dump_close(dump);
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DUMP_MAGIC "SIMDDUMP"
+#define DUMP_HEADER_BYTES 64
+#define DUMP_NAME_BYTES 48
+
+static inline FILE *dump_open(const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (!f || fwrite(DUMP_MAGIC, 1, strlen(DUMP_MAGIC), f) != strlen(DUMP_MAGIC)) {
+        fprintf(stderr, "dump: cannot write %s\n", path);
+        exit(1);
+    }
+    return f;
+}
+
+// Removes "--dump FILE" from argv and opens FILE; NULL when absent
+static inline FILE *dump_option(int *argc, char **argv) {
+    for (int i = 1; i + 1 < *argc; i++) {
+        if (strcmp(argv[i], "--dump") == 0) {
+            FILE *f = dump_open(argv[i + 1]);
+            for (int j = i; j + 2 <= *argc; j++) argv[j] = argv[j + 2];
+            *argc -= 2;
+            return f;
+        }
+    }
+    return NULL;
+}
+
+// One record of count 8-byte elements; dtype "<f8" or "<i8"
+static inline void dump_record(FILE *f, const char *name, const char *dtype,
+                               const void *data, size_t count) {
+    unsigned char header[DUMP_HEADER_BYTES] = {0};
+    strncpy((char *)header, name, DUMP_NAME_BYTES - 1);
+    memcpy(header + DUMP_NAME_BYTES, dtype, strlen(dtype));
+    for (int b = 0; b < 8; b++) {
+        header[DUMP_HEADER_BYTES - 8 + b] = (unsigned char)((uint64_t)count >> (8 * b));
+    }
+    fwrite(header, 1, sizeof(header), f);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    const unsigned char *bytes = data;
+    for (size_t i = 0; i < count; i++) {
+        unsigned char le[8];
+        for (int b = 0; b < 8; b++) le[b] = bytes[8 * i + 7 - b];
+        fwrite(le, 1, sizeof(le), f);
+    }
+#else
+    fwrite(data, 8, count, f);
+#endif
+}
+
+static inline void dump_doubles(FILE *f, const char *name, const double *data, size_t count) {
+    dump_record(f, name, "<f8", data, count);
+}
+
+static inline void dump_int64s(FILE *f, const char *name, const int64_t *data, size_t count) {
+    dump_record(f, name, "<i8", data, count);
+}
+
+static inline void dump_close(FILE *f) {
+    int failed = ferror(f);
+    if (fclose(f) != 0 || failed) {
+        fprintf(stderr, "dump: write failed\n");
+        exit(1);
+    }
+}
+
+#endif
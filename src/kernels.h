@@ -0,0 +1,47 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+/*
+ * Runtime-length versions of the test patterns, built as separate objects so
+ * the Cilk Plus (GCC 7) and OpenMP SIMD variants can be linked and timed in
+ * one process:
+ *   kernels_cilk.c    requires GCC 7 with -fcilkplus
+ *   kernels_openmp.c  any compiler with -fopenmp-simd
+ */
+
+#include "common.h"
+
+// Reduction results of one kernel run
+typedef struct {
+    int count;
+    double sum;
+    double sum2;
+} kernel_result;
+
+// Pattern A, A2 and B over input[0:n]
+typedef void (*kernel_fn)(int n, const double *input, const int *flags,
+                          double *output, double *intermediate,
+                          kernel_result *result);
+
+void kernel_cilk(int n, const double *input, const int *flags,
+                 double *output, double *intermediate, kernel_result *result);
+void kernel_openmp(int n, const double *input, const int *flags,
+                   double *output, double *intermediate, kernel_result *result);
+// kernel_openmp with reproducible double sums (reprosum.h)
+void kernel_openmp_repro(int n, const double *input, const int *flags,
+                         double *output, double *intermediate, kernel_result *result);
+
+// Sum of x[0:n]: an omp simd reduction, or in the fixed order of reprosum.h
+typedef double (*sum_fn)(const double *x, int n);
+
+double sum_openmp(const double *x, int n);
+double sum_openmp_repro(const double *x, int n);
+
+// __VERSION__ of the compiler that built each variant
+extern const char kernel_cilk_compiler[];
+extern const char kernel_openmp_compiler[];
+
+// Clone of the multiversioned OpenMP kernel selected on this CPU (dispatch.h)
+const char *kernel_openmp_isa(void);
+
+#endif
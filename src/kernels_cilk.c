@@ -0,0 +1,27 @@
+/*
+ * Cilk Plus kernel variant for the in-process benchmark runner
+ * Requires: GCC 7.x with -fcilkplus flag
+ */
+
+#include <math.h>
+#include "kernels.h"
+
+const char kernel_cilk_compiler[] = __VERSION__;
+
+void kernel_cilk(int n, const double *input, const int *flags,
+                 double *output, double *intermediate, kernel_result *result) {
+    // Pattern A: Array section with transcendental
+    output[0:n] = -log(input[0:n]) * 2.0;
+
+    // Pattern A2: Chained operations
+    intermediate[0:n] = exp(-input[0:n]) / (input[0:n] + 0.1);
+
+    // Pattern B: Reductions
+    int count = __sec_reduce_add(flags[0:n]);
+    double sum = __sec_reduce_add(output[0:n]);
+    double sum2 = __sec_reduce_add(intermediate[0:n]);
+
+    result->count = count;
+    result->sum = sum;
+    result->sum2 = sum2;
+}
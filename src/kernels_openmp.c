@@ -0,0 +1,102 @@
+/*
+ * OpenMP SIMD kernel variant for the in-process benchmark runner
+ * Requires: Any modern compiler with OpenMP support
+ *
+ * kernel_openmp is built for AVX-512F, AVX2 and baseline x86-64 and the
+ * clone is picked at startup (dispatch.h); kernel_openmp_isa() reports it.
+ *
+ * kernel_openmp_repro computes the same patterns with the double sums of
+ * reprosum.h, whose results do not depend on the clone that runs;
+ * sum_openmp and sum_openmp_repro time the two sums alone.
+ */
+
+#include <math.h>
+#include "kernels.h"
+#include "vecmath.h"
+#include "dispatch.h"
+#include "reprosum.h"
+
+const char kernel_openmp_compiler[] = __VERSION__;
+
+const char *kernel_openmp_isa(void) {
+    return dispatch_isa();
+}
+
+DISPATCH_CLONES
+void kernel_openmp(int n, const double *input, const int *flags,
+                   double *output, double *intermediate, kernel_result *result) {
+    // Pattern A converted
+    #pragma omp simd
+    for (int i = 0; i < n; i++) {
+        output[i] = -log(input[i]) * 2.0;
+    }
+
+    // Pattern A2 converted
+    #pragma omp simd
+    for (int i = 0; i < n; i++) {
+        intermediate[i] = exp(-input[i]) / (input[i] + 0.1);
+    }
+
+    // Pattern B converted
+    int count = 0;
+    #pragma omp simd reduction(+:count)
+    for (int i = 0; i < n; i++) {
+        count += flags[i];
+    }
+
+    double sum = 0.0;
+    #pragma omp simd reduction(+:sum)
+    for (int i = 0; i < n; i++) {
+        sum += output[i];
+    }
+
+    double sum2 = 0.0;
+    #pragma omp simd reduction(+:sum2)
+    for (int i = 0; i < n; i++) {
+        sum2 += intermediate[i];
+    }
+
+    result->count = count;
+    result->sum = sum;
+    result->sum2 = sum2;
+}
+
+DISPATCH_CLONES
+void kernel_openmp_repro(int n, const double *input, const int *flags,
+                         double *output, double *intermediate, kernel_result *result) {
+    #pragma omp simd
+    for (int i = 0; i < n; i++) {
+        output[i] = -log(input[i]) * 2.0;
+    }
+
+    #pragma omp simd
+    for (int i = 0; i < n; i++) {
+        intermediate[i] = exp(-input[i]) / (input[i] + 0.1);
+    }
+
+    // Integer sums are exact in any order
+    int count = 0;
+    #pragma omp simd reduction(+:count)
+    for (int i = 0; i < n; i++) {
+        count += flags[i];
+    }
+
+    result->count = count;
+    result->sum = repro_sum(output, n);
+    result->sum2 = repro_sum(intermediate, n);
+}
+
+DISPATCH_CLONES
+double sum_openmp(const double *x, int n) {
+    double sum = 0.0;
+    #pragma omp simd reduction(+:sum)
+    for (int i = 0; i < n; i++) {
+        sum += x[i];
+    }
+    return sum;
+}
+
+DISPATCH_CLONES
+double sum_openmp_repro(const double *x, int n) {
+    return repro_sum(x, n);
+}
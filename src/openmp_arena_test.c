@@ -0,0 +1,75 @@
+/*
+ * OpenMP SIMD section temporaries test: stack VLA, malloc and arena scratch
+ * Requires: Any modern compiler with OpenMP SIMD support (-fopenmp-simd)
+ *
+ * The conversion of cilk_arena_test.c, with the diffusion step's flux and
+ * spread temporaries taken from three places:
+ * 1. VLA: on the stack, as in the Cilk source
+ * 2. MALLOC: malloc/free per call, which for n above 16K doubles is an
+ *    mmap and munmap each time, with fresh page faults
+ * 3. ARENA: the thread's arena.h buffer, released by ARENA_SCOPE; this is
+ *    what the converter's --arena mode emits
+ * All three run the same loops, so they must produce the same bits.
+ *
+ * Usage: openmp_arena_test [N ...]   sizes, default TEMPS_SIZES
+ */
+
+#include <stdio.h>
+#include "common.h"
+#include "arena.h"
+#include "temporaries.h"
+
+static inline void diffuse(const double *in, double *out, int n, double *flux, double *spread) {
+    #pragma omp simd
+    for (int i = 0; i < n; i++) {
+        flux[i] = in[i] * (1.0 - in[i]);
+    }
+    #pragma omp simd
+    for (int i = 0; i < n; i++) {
+        spread[i] = 0.5 * flux[i];
+    }
+    // Half of each flux goes to the neighbours, a quarter each way
+    #pragma omp simd
+    for (int i = 0; i < n - 1; i++) {
+        spread[1 + i] += 0.25 * flux[i];
+    }
+    #pragma omp simd
+    for (int i = 0; i < n - 1; i++) {
+        spread[i] += 0.25 * flux[1 + i];
+    }
+    #pragma omp simd
+    for (int i = 0; i < n; i++) {
+        out[i] = in[i] + TEMPS_DT * (spread[i] - flux[i]);
+    }
+}
+
+static void step_vla(const double *in, double *out, int n) {
+    double flux[n];
+    double spread[n];
+    diffuse(in, out, n, flux, spread);
+}
+
+static void step_malloc(const double *in, double *out, int n) {
+    double *flux = malloc(sizeof(double) * n);
+    double *spread = malloc(sizeof(double) * n);
+    if (!flux || !spread) {
+        fprintf(stderr, "cannot allocate %d-element temporaries\n", n);
+        exit(1);
+    }
+    diffuse(in, out, n, flux, spread);
+    free(flux);
+    free(spread);
+}
+
+static void step_arena(const double *in, double *out, int n) {
+    ARENA_SCOPE;
+    double *flux = arena_alloc(n, sizeof(double));
+    double *spread = arena_alloc(n, sizeof(double));
+    diffuse(in, out, n, flux, spread);
+}
+
+int main(int argc, char **argv) {
+    static const temps_variant variants[] = {
+        {"VLA", step_vla}, {"MALLOC", step_malloc}, {"ARENA", step_arena}};
+    return temps_main(argc - 1, argv + 1, variants, 3);
+}
@@ -0,0 +1,50 @@
+/*
+ * OpenMP SIMD stream compaction test: packing the alive particles of a batch
+ * Requires: Any modern compiler with OpenMP 5.0 SIMD support (-fopenmp-simd)
+ *
+ * The conversion of cilk_compact_test.c. The masked append becomes an
+ * inscan reduction: each particle stores its index at the number of alive
+ * particles before it, so the loop is an exclusive prefix sum of the mask
+ * instead of a branch on a loop-carried counter. GCC vectorizes it with
+ * AVX-512 scatters (-march=native on AVX-512 machines); without a scatter
+ * instruction it stays scalar, but still has no branch to mispredict. The
+ * gathers vectorize on AVX2 too.
+ *
+ * Usage: openmp_compact_test [N ...]   batch sizes, default PARTICLE_BATCH
+ */
+
+#include <stdio.h>
+#include "common.h"
+#include "compact.h"
+
+static int pack_soa(particle_batch *in, particle_batch *out, int *keep) {
+    int n = in->n;
+    int *alive = in->alive;
+    int kept = 0;
+
+    #pragma omp simd reduction(inscan, +:kept)
+    for (int i = 0; i < n; i++) {
+        if (alive[i] != 0) {
+            keep[kept] = i;
+        }
+        #pragma omp scan exclusive(kept)
+        kept += alive[i] != 0;
+    }
+    for (int f = 0; f < PT_FIELDS; f++) {
+        double *src = in->field[f], *dst = out->field[f];
+        #pragma omp simd
+        for (int i = 0; i < kept; i++) {
+            dst[i] = src[keep[i]];
+        }
+    }
+    #pragma omp simd
+    for (int i = 0; i < kept; i++) {
+        out->alive[i] = 1;
+    }
+    out->n = kept;
+    return kept;
+}
+
+int main(int argc, char **argv) {
+    return compact_main(argc - 1, argv + 1, pack_soa);
+}
@@ -0,0 +1,94 @@
+/*
+ * OpenMP SIMD particle transport test: SoA and AoS batches
+ * Requires: Any modern compiler with OpenMP SIMD support (-fopenmp-simd)
+ *
+ * The conversion of cilk_particles_test.c: each transport step is one
+ * omp simd loop over the batch and __sec_reduce_add a reduction clause.
+ * Instead of masking every store, dead particles take a zero-length step,
+ * which leaves all their fields unchanged bit for bit. In the AoS variant
+ * the strided sections become accesses to the particle's record, which the
+ * vectorizer has to gather and scatter.
+ *
+ * Like Pattern D, the loops only vectorize with -fno-trapping-math
+ * -fno-math-errno and a vector exp (vecmath.h, -DVECMATH_LIBMVEC).
+ *
+ * Usage: openmp_particles_test [N ...]   batch sizes, default PARTICLE_BATCH
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include "common.h"
+#include "vecmath.h"
+
+#define BENCH_REPS 21  // each sample transports a whole batch to the end
+#include "particles.h"
+
+static void step_soa(particle_batch *b, particle_tally *t) {
+    int n = b->n;
+    double *x = b->field[PT_X], *y = b->field[PT_Y], *z = b->field[PT_Z];
+    double *u = b->field[PT_U], *v = b->field[PT_V], *w = b->field[PT_W];
+    double *energy = b->field[PT_ENERGY], *weight = b->field[PT_WEIGHT];
+    int *alive = b->alive;
+    long long deposited = 0;
+
+    #pragma omp simd reduction(+:deposited)
+    for (int i = 0; i < n; i++) {
+        int mask = alive[i];
+        double e = energy[i];
+        int water = z[i] < PT_SLAB;
+        // Dead particles take a zero-length step, which leaves them unchanged
+        double step = mask ? PT_STEP * (e + 1.0) / (e + PT_E0) : 0.0;
+        double loss = e * (1.0 - exp(-(water ? PT_LOSS_WATER : PT_LOSS_AIR) * step / (e + 1.0)));
+        double turn = (water ? PT_SCATTER : 0.0) * step / (e + 1.0);
+        double nu = (u[i] * (1.0 - turn * turn) - 2.0 * w[i] * turn) / (1.0 + turn * turn);
+        double nw = (w[i] * (1.0 - turn * turn) + 2.0 * u[i] * turn) / (1.0 + turn * turn);
+        energy[i] = e - loss;
+        u[i] = nu;
+        w[i] = nw;
+        x[i] += nu * step;
+        y[i] += v[i] * step;
+        z[i] += nw * step;
+        weight[i] *= exp(-PT_ATTENUATION * step);
+        double deposit = mask ? (loss + (energy[i] <= PT_CUTOFF ? energy[i] : 0.0)) * weight[i] : 0.0;
+        deposited += (int)(deposit * DOSE_SCALE);
+        alive[i] = mask & (energy[i] > PT_CUTOFF) & (z[i] >= 0.0) & (z[i] < PT_DEPTH) &
+                   (fabs(x[i]) < PT_WIDTH) & (fabs(y[i]) < PT_WIDTH);
+    }
+    t->dose += deposited;
+}
+
+static void step_aos(particle_batch *b, particle_tally *t) {
+    int n = b->n;
+    double *r = b->records;
+    int *alive = b->alive;
+    long long deposited = 0;
+
+    #pragma omp simd reduction(+:deposited)
+    for (int i = 0; i < n; i++) {
+        double *p = &r[i * PT_FIELDS];
+        int mask = alive[i];
+        double e = p[PT_ENERGY];
+        int water = p[PT_Z] < PT_SLAB;
+        double step = mask ? PT_STEP * (e + 1.0) / (e + PT_E0) : 0.0;
+        double loss = e * (1.0 - exp(-(water ? PT_LOSS_WATER : PT_LOSS_AIR) * step / (e + 1.0)));
+        double turn = (water ? PT_SCATTER : 0.0) * step / (e + 1.0);
+        double nu = (p[PT_U] * (1.0 - turn * turn) - 2.0 * p[PT_W] * turn) / (1.0 + turn * turn);
+        double nw = (p[PT_W] * (1.0 - turn * turn) + 2.0 * p[PT_U] * turn) / (1.0 + turn * turn);
+        p[PT_ENERGY] = e - loss;
+        p[PT_U] = nu;
+        p[PT_W] = nw;
+        p[PT_X] += nu * step;
+        p[PT_Y] += p[PT_V] * step;
+        p[PT_Z] += nw * step;
+        p[PT_WEIGHT] *= exp(-PT_ATTENUATION * step);
+        double deposit = mask ? (loss + (p[PT_ENERGY] <= PT_CUTOFF ? p[PT_ENERGY] : 0.0)) * p[PT_WEIGHT] : 0.0;
+        deposited += (int)(deposit * DOSE_SCALE);
+        alive[i] = mask & (p[PT_ENERGY] > PT_CUTOFF) & (p[PT_Z] >= 0.0) & (p[PT_Z] < PT_DEPTH) &
+                   (fabs(p[PT_X]) < PT_WIDTH) & (fabs(p[PT_Y]) < PT_WIDTH);
+    }
+    t->dose += deposited;
+}
+
+int main(int argc, char **argv) {
+    return particles_main(argc - 1, argv + 1, step_soa, step_aos);
+}
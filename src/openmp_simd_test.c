@@ -4,17 +4,82 @@
  *
  * This demonstrates the conversion pattern from Cilk Plus to OpenMP SIMD:
  * - Array notation a[0:N] = expr(b[0:N]) becomes #pragma omp simd + loop
- * - __sec_reduce_add() becomes #pragma omp simd reduction(+:var)
+ * - __sec_reduce_add() becomes #pragma omp simd reduction(+:var), and
+ *   max, min, mul, any_nonzero and all_zero use the max, min, *, || and &&
+ *   reduction identifiers
+ * - __sec_reduce_max_ind()/min_ind() reduce the value and a NaN flag, then the
+ *   lowest index holding the value (the first NaN when the flag is set)
+ * - Strided and offset sections a[s:n:k] index a[s + i*k]
+ * - Masked if/else blocks become selects: mask ? then : else
+ * - A section written only to be reduced is fused with the reduction and
+ *   kept in a scalar
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <math.h>
-#include <time.h>
+#include <string.h>
 #include "common.h"
+#include "bench.h"
+#include "dump.h"
+#include "kernels.h"
+#include "perfcount.h"
+#include "vecmath.h"
 
 #define ITERATIONS 100
+#define PERF_ITERATIONS 10000  // repetitions of each block under the counters
+
+// --sum-overhead [N ...]: the omp simd sum against repro_sum() alone, per size
+static int sum_overhead(int argc, char **argv) {
+    static const int default_sizes[] = { SWEEP_SIZES };
+    int count = argc > 0 ? argc : (int)(sizeof(default_sizes) / sizeof(default_sizes[0]));
+
+    printf("BENCH_ISA=%s\n", kernel_openmp_isa());
+    for (int s = 0; s < count; s++) {
+        int n = argc > 0 ? atoi(argv[s]) : default_sizes[s];
+        if (n <= 0) {
+            fprintf(stderr, "bench: invalid size '%s'\n", argv[s]);
+            return 1;
+        }
+
+        double *input = test_alloc(n, sizeof(double));
+        int *flags = test_alloc(n, sizeof(int));
+        test_fill(input, flags, n);
+
+        bench_run simd, repro;
+        bench_sum(&simd, sum_openmp, input, n);
+        bench_sum(&repro, sum_openmp_repro, input, n);
+
+        char name[48];
+        snprintf(name, sizeof(name), "BENCH_SUM_SIMD_N%d", n);
+        bench_report(name, &simd);
+        snprintf(name, sizeof(name), "BENCH_SUM_REPRO_N%d", n);
+        bench_report(name, &repro);
+        printf("BENCH_SUM_REPRO_N%d_OVERHEAD=%.3f\n", n, repro.median_ns / simd.median_ns);
+
+        free(input);
+        free(flags);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    // --dump FILE writes the arrays to a binary dump (dump.h) instead of printing them
+    FILE *dump = dump_option(&argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--sweep") == 0) {
+        // --sweep --repro times the kernel with reproducible sums (reprosum.h)
+        int repro = argc > 2 && strcmp(argv[2], "--repro") == 0;
+        printf("BENCH_ISA=%s\n", kernel_openmp_isa());
+        int status = bench_sweep(argc - 2 - repro, argv + 2 + repro,
+                                 repro ? kernel_openmp_repro : kernel_openmp, dump);
+        if (dump) dump_close(dump);
+        return status;
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--sum-overhead") == 0) {
+        return sum_overhead(argc - 2, argv + 2);
+    }
 
-int main(void) {
     double input[VLENGTH];
     double output[VLENGTH];
     double intermediate[VLENGTH];
@@ -31,22 +96,78 @@ int main(void) {
         flags[i] = TEST_FLAGS[i];
     }
 
-    clock_t start = clock();
+    bench_run run;
+    bench_begin(&run, (double)ITERATIONS * VLENGTH);
+
+    while (bench_next(&run)) {
+        for (int iter = 0; iter < ITERATIONS; iter++) {
+            // Pattern A converted: explicit loop with SIMD hint
+            #pragma omp simd
+            for (int i = 0; i < VLENGTH; i++) {
+                output[i] = -log(input[i]) * 2.0;
+            }
+
+            // Pattern A2 converted: chained operations
+            #pragma omp simd
+            for (int i = 0; i < VLENGTH; i++) {
+                intermediate[i] = exp(-input[i]) / (input[i] + 0.1);
+            }
+
+            // Pattern B converted: explicit reduction with SIMD
+            int count = 0;
+            #pragma omp simd reduction(+:count)
+            for (int i = 0; i < VLENGTH; i++) {
+                count += flags[i];
+            }
+
+            double sum = 0.0;
+            #pragma omp simd reduction(+:sum)
+            for (int i = 0; i < VLENGTH; i++) {
+                sum += output[i];
+            }
+
+            double sum2 = 0.0;
+            #pragma omp simd reduction(+:sum2)
+            for (int i = 0; i < VLENGTH; i++) {
+                sum2 += intermediate[i];
+            }
+
+            // Accumulate to prevent optimization
+            acc_sum += sum;
+            acc_sum2 += sum2;
+            acc_count += count;
+        }
+    }
+
+    bench_end(&run);
 
-    for (int iter = 0; iter < ITERATIONS; iter++) {
-        // Pattern A converted: explicit loop with SIMD hint
+#ifdef PERF_COUNTERS
+    // Each pattern block again under hardware counters (perfcount.h), after the
+    // timed samples so they carry no counter overhead
+    perfcount_group perf;
+    perfcount_sample perf_a, perf_a2, perf_b;
+    perfcount_open(&perf);
+
+    perfcount_start(&perf);
+    for (int iter = 0; iter < PERF_ITERATIONS; iter++) {
         #pragma omp simd
         for (int i = 0; i < VLENGTH; i++) {
             output[i] = -log(input[i]) * 2.0;
         }
+    }
+    perfcount_stop(&perf, &perf_a, (double)PERF_ITERATIONS * VLENGTH);
 
-        // Pattern A2 converted: chained operations
+    perfcount_start(&perf);
+    for (int iter = 0; iter < PERF_ITERATIONS; iter++) {
         #pragma omp simd
         for (int i = 0; i < VLENGTH; i++) {
             intermediate[i] = exp(-input[i]) / (input[i] + 0.1);
         }
+    }
+    perfcount_stop(&perf, &perf_a2, (double)PERF_ITERATIONS * VLENGTH);
 
-        // Pattern B converted: explicit reduction with SIMD
+    perfcount_start(&perf);
+    for (int iter = 0; iter < PERF_ITERATIONS; iter++) {
         int count = 0;
         #pragma omp simd reduction(+:count)
         for (int i = 0; i < VLENGTH; i++) {
@@ -65,18 +186,24 @@ int main(void) {
             sum2 += intermediate[i];
         }
 
-        // Accumulate to prevent optimization
         acc_sum += sum;
         acc_sum2 += sum2;
         acc_count += count;
     }
-
-    clock_t end = clock();
-    double elapsed_ms = (double)(end - start) / CLOCKS_PER_SEC * 1000.0;
+    perfcount_stop(&perf, &perf_b, (double)PERF_ITERATIONS * VLENGTH);
+#endif
 
     // Timing first
-    printf("TIMING_MS=%.3f\n", elapsed_ms);
+    printf("TIMING_MS=%.3f\n", run.total_ms);
     printf("ITERATIONS=%d\n", ITERATIONS);
+    bench_report("BENCH", &run);
+#ifdef PERF_COUNTERS
+    perfcount_status(&perf);
+    perfcount_report("PERF_A", &perf_a);
+    perfcount_report("PERF_A2", &perf_a2);
+    perfcount_report("PERF_B", &perf_b);
+    perfcount_close(&perf);
+#endif
 
     // Results from last iteration (recompute to get final values)
     #pragma omp simd
@@ -106,16 +233,159 @@ int main(void) {
         sum2 += intermediate[i];
     }
 
-    printf("VLENGTH=%d\n", VLENGTH);
-    printf("REDUCTION_COUNT=%d\n", count);
-    printf("REDUCTION_SUM=%.15g\n", sum);
-    printf("REDUCTION_SUM2=%.15g\n", sum2);
+    // Pattern B2 converted: max/min/* reductions, starting from the first element
+    double max_out = output[0];
+    double min_out = output[0];
+    #pragma omp simd reduction(max:max_out) reduction(min:min_out)
+    for (int i = 0; i < VLENGTH; i++) {
+        max_out = output[i] > max_out ? output[i] : max_out;
+        min_out = output[i] < min_out ? output[i] : min_out;
+    }
+
+    double prod = 1.0;
+    #pragma omp simd reduction(*:prod)
+    for (int i = 0; i < VLENGTH; i++) {
+        prod *= input[i];
+    }
+
+    // _ind variants: reduce the extreme value and whether any element is NaN,
+    // then the lowest index holding the value, or the first NaN
+    double max_value = intermediate[0];
+    double min_value = intermediate[0];
+    int has_nan = 0;
+    #pragma omp simd reduction(max:max_value) reduction(min:min_value) reduction(||:has_nan)
+    for (int i = 0; i < VLENGTH; i++) {
+        max_value = intermediate[i] > max_value ? intermediate[i] : max_value;
+        min_value = intermediate[i] < min_value ? intermediate[i] : min_value;
+        has_nan = has_nan || intermediate[i] != intermediate[i];
+    }
+
+    int max_ind = VLENGTH;
+    int min_ind = VLENGTH;
+    #pragma omp simd reduction(min:max_ind,min_ind)
+    for (int i = 0; i < VLENGTH; i++) {
+        if ((has_nan ? intermediate[i] != intermediate[i] : intermediate[i] == max_value) && i < max_ind) max_ind = i;
+        if ((has_nan ? intermediate[i] != intermediate[i] : intermediate[i] == min_value) && i < min_ind) min_ind = i;
+    }
 
+    int any_flag = 0;
+    int no_flags = 1;
+    #pragma omp simd reduction(||:any_flag) reduction(&&:no_flags)
     for (int i = 0; i < VLENGTH; i++) {
-        printf("OUTPUT[%d]=%.15g\n", i, output[i]);
+        any_flag = any_flag || flags[i] != 0;
+        no_flags = no_flags && flags[i] == 0;
     }
+
+    // All-NaN section: vector max/min drop NaN operands, so the reduced value
+    // can come out as -inf/+inf and match no element; the NaN flag makes the
+    // result the first element's, not VLENGTH
+    double undefined[VLENGTH];
+    #pragma omp simd
+    for (int i = 0; i < VLENGTH; i++) {
+        undefined[i] = NAN;
+    }
+    double nan_max_value = undefined[0];
+    double nan_min_value = undefined[0];
+    int undefined_nan = 0;
+    #pragma omp simd reduction(max:nan_max_value) reduction(min:nan_min_value) reduction(||:undefined_nan)
+    for (int i = 0; i < VLENGTH; i++) {
+        nan_max_value = undefined[i] > nan_max_value ? undefined[i] : nan_max_value;
+        nan_min_value = undefined[i] < nan_min_value ? undefined[i] : nan_min_value;
+        undefined_nan = undefined_nan || undefined[i] != undefined[i];
+    }
+    int nan_max_ind = VLENGTH;
+    int nan_min_ind = VLENGTH;
+    #pragma omp simd reduction(min:nan_max_ind,nan_min_ind)
+    for (int i = 0; i < VLENGTH; i++) {
+        if ((undefined_nan ? undefined[i] != undefined[i] : undefined[i] == nan_max_value) && i < nan_max_ind)
+            nan_max_ind = i;
+        if ((undefined_nan ? undefined[i] != undefined[i] : undefined[i] == nan_min_value) && i < nan_min_ind)
+            nan_min_ind = i;
+    }
+
+    // Pattern C converted: sections index start + i*stride
+    int stride = 3;  // x, y, z per record
+    double records[3 * VLENGTH];
+    double path[VLENGTH];
+    #pragma omp simd
+    for (int i = 0; i < VLENGTH; i++) {
+        records[i * stride] = input[i];
+        records[1 + i * stride] = input[i] * 2.0;
+        records[2 + i * 3] = intermediate[i];
+    }
+    #pragma omp simd
+    for (int i = 0; i < VLENGTH; i++) {
+        path[i] = records[i * stride] + records[1 + i * stride] * records[2 + i * 3];
+    }
+
+    double tail_sum = 0.0;
+    #pragma omp simd reduction(+:tail_sum)
+    for (int i = 0; i < VLENGTH - 2; i++) {
+        tail_sum += output[2 + i];
+    }
+
+    // Pattern D converted: branchless selects on a per-element mask
+    double weight[VLENGTH];
+    double deposit[VLENGTH];
+    #pragma omp simd
+    for (int i = 0; i < VLENGTH; i++) {
+        int mask = input[i] > 0.45;
+        weight[i] = mask ? exp(-input[i]) : 0.0;
+        deposit[i] = mask ? weight[i] * output[i] : input[i] * 0.5;
+    }
+    #pragma omp simd
+    for (int i = 0; i < VLENGTH; i++) {
+        int mask = flags[i] != 0;
+        deposit[i] = mask ? deposit[i] + intermediate[i] : deposit[i];
+    }
+
+    // Pattern E converted: fused, the single-use temporary is a scalar
+    double dose = 0;
+    #pragma omp simd reduction(+:dose)
     for (int i = 0; i < VLENGTH; i++) {
-        printf("INTERMEDIATE[%d]=%.15g\n", i, intermediate[i]);
+        double loss = input[i] * (1.0 + intermediate[i]);
+        dose += loss * weight[i];
+    }
+
+    printf("VLENGTH=%d\n", VLENGTH);
+    printf("REDUCTION_COUNT=%d\n", count);
+    printf("REDUCTION_SUM=%.17g\n", sum);
+    printf("REDUCTION_SUM2=%.17g\n", sum2);
+    printf("REDUCTION_MAX=%.17g\n", max_out);
+    printf("REDUCTION_MIN=%.17g\n", min_out);
+    printf("REDUCTION_MUL=%.17g\n", prod);
+    printf("REDUCTION_MAX_IND=%d\n", max_ind);
+    printf("REDUCTION_MIN_IND=%d\n", min_ind);
+    printf("REDUCTION_NAN_MAX_IND=%d\n", nan_max_ind);
+    printf("REDUCTION_NAN_MIN_IND=%d\n", nan_min_ind);
+    printf("REDUCTION_ANY_NONZERO=%d\n", any_flag);
+    printf("REDUCTION_ALL_ZERO=%d\n", no_flags);
+    printf("REDUCTION_TAIL_SUM=%.17g\n", tail_sum);
+    printf("REDUCTION_DOSE=%.17g\n", dose);
+
+    if (dump) {
+        dump_doubles(dump, "OUTPUT", output, VLENGTH);
+        dump_doubles(dump, "INTERMEDIATE", intermediate, VLENGTH);
+        dump_doubles(dump, "PATH", path, VLENGTH);
+        dump_doubles(dump, "WEIGHT", weight, VLENGTH);
+        dump_doubles(dump, "DEPOSIT", deposit, VLENGTH);
+        dump_close(dump);
+    } else {
+        for (int i = 0; i < VLENGTH; i++) {
+            printf("OUTPUT[%d]=%.17g\n", i, output[i]);
+        }
+        for (int i = 0; i < VLENGTH; i++) {
+            printf("INTERMEDIATE[%d]=%.17g\n", i, intermediate[i]);
+        }
+        for (int i = 0; i < VLENGTH; i++) {
+            printf("PATH[%d]=%.17g\n", i, path[i]);
+        }
+        for (int i = 0; i < VLENGTH; i++) {
+            printf("WEIGHT[%d]=%.17g\n", i, weight[i]);
+        }
+        for (int i = 0; i < VLENGTH; i++) {
+            printf("DEPOSIT[%d]=%.17g\n", i, deposit[i]);
+        }
     }
 
     return 0;
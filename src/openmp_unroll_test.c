@@ -0,0 +1,142 @@
+/*
+ * OpenMP SIMD compile-time extent test: generic against specialized loops
+ * Requires: Any modern compiler with OpenMP SIMD support (-fopenmp-simd)
+ *
+ * Patterns A, A2 and B of cilk_test.c over one VLENGTH section, as the
+ * converter emits them:
+ * 1. GENERIC: the default output, an omp simd loop per statement
+ * 2. UNROLLED: the --unroll-constant output, where the log and exp loops,
+ *    which omp simd cannot vectorize without a vector math library, are
+ *    UNROLL(VLENGTH) loops (unroll.h) and the reductions get the exact
+ *    simdlen/safelen of the extent
+ * Both run the same operations in the same order, so they must produce the
+ * same bits. Build once per width to see what specializing gains there:
+ *   gcc -fopenmp-simd -O2 -DVLENGTH=4 -o openmp_unroll_test src/openmp_unroll_test.c -lm
+ * and likewise for 8 and 16.
+ *
+ * The kernels are called through bench_kernel() on heap buffers, so the
+ * compiler cannot fold the test inputs into the unrolled calls.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "common.h"
+#include "bench.h"
+#include "unroll.h"
+
+typedef struct {
+    const char *name;  // BENCH_<name>_*
+    kernel_fn kernel;  // called with n == VLENGTH
+} unroll_variant;
+
+static void kernel_generic(int n, const double *input, const int *flags,
+                           double *output, double *intermediate, kernel_result *result) {
+    (void)n;
+    #pragma omp simd
+    for (int i = 0; i < VLENGTH; i++) {
+        output[i] = -log(input[i]) * 2.0;
+    }
+    #pragma omp simd
+    for (int i = 0; i < VLENGTH; i++) {
+        intermediate[i] = exp(-input[i]) / (input[i] + 0.1);
+    }
+
+    int count = 0;
+    #pragma omp simd reduction(+:count)
+    for (int i = 0; i < VLENGTH; i++) {
+        count += flags[i];
+    }
+    double sum = 0;
+    #pragma omp simd reduction(+:sum)
+    for (int i = 0; i < VLENGTH; i++) {
+        sum += output[i];
+    }
+    double sum2 = 0;
+    #pragma omp simd reduction(+:sum2)
+    for (int i = 0; i < VLENGTH; i++) {
+        sum2 += intermediate[i];
+    }
+
+    result->count = count;
+    result->sum = sum;
+    result->sum2 = sum2;
+}
+
+static void kernel_unrolled(int n, const double *input, const int *flags,
+                            double *output, double *intermediate, kernel_result *result) {
+    (void)n;
+    UNROLL(VLENGTH)
+    for (int i = 0; i < VLENGTH; i++) {
+        output[i] = -log(input[i]) * 2.0;
+    }
+    UNROLL(VLENGTH)
+    for (int i = 0; i < VLENGTH; i++) {
+        intermediate[i] = exp(-input[i]) / (input[i] + 0.1);
+    }
+
+    int count = 0;
+    #pragma omp simd simdlen(VLENGTH) safelen(VLENGTH) reduction(+:count)
+    for (int i = 0; i < VLENGTH; i++) {
+        count += flags[i];
+    }
+    double sum = 0;
+    #pragma omp simd simdlen(VLENGTH) safelen(VLENGTH) reduction(+:sum)
+    for (int i = 0; i < VLENGTH; i++) {
+        sum += output[i];
+    }
+    double sum2 = 0;
+    #pragma omp simd simdlen(VLENGTH) safelen(VLENGTH) reduction(+:sum2)
+    for (int i = 0; i < VLENGTH; i++) {
+        sum2 += intermediate[i];
+    }
+
+    result->count = count;
+    result->sum = sum;
+    result->sum2 = sum2;
+}
+
+int main(void) {
+    static const unroll_variant variants[] = {
+        {"GENERIC", kernel_generic}, {"UNROLLED", kernel_unrolled}};
+    double *input = test_alloc(VLENGTH, sizeof(double));
+    int *flags = test_alloc(VLENGTH, sizeof(int));
+    double *outputs[2], *intermediates[2];
+    kernel_result results[2];
+    double median_ns[2];
+    char name[64];
+
+    test_fill(input, flags, VLENGTH);
+    printf("UNROLL_VLENGTH=%d\n", VLENGTH);
+
+    for (int v = 0; v < 2; v++) {
+        bench_run run;
+        outputs[v] = test_alloc(VLENGTH, sizeof(double));
+        intermediates[v] = test_alloc(VLENGTH, sizeof(double));
+        bench_kernel(&run, variants[v].kernel, VLENGTH, input, flags,
+                     outputs[v], intermediates[v], &results[v]);
+        median_ns[v] = run.median_ns;
+
+        printf("%s_COUNT=%d\n", variants[v].name, results[v].count);
+        printf("%s_SUM=%.17g\n", variants[v].name, results[v].sum);
+        printf("%s_SUM2=%.17g\n", variants[v].name, results[v].sum2);
+        snprintf(name, sizeof(name), "BENCH_%s", variants[v].name);
+        bench_report(name, &run);
+    }
+
+    int match = results[0].count == results[1].count
+        && memcmp(&results[0].sum, &results[1].sum, sizeof(double)) == 0
+        && memcmp(&results[0].sum2, &results[1].sum2, sizeof(double)) == 0
+        && memcmp(outputs[0], outputs[1], sizeof(double) * VLENGTH) == 0
+        && memcmp(intermediates[0], intermediates[1], sizeof(double) * VLENGTH) == 0;
+    printf("RESULTS_MATCH=%d\n", match);
+    printf("BENCH_UNROLL_SPEEDUP=%.3f\n", median_ns[0] / median_ns[1]);
+
+    free(input);
+    free(flags);
+    for (int v = 0; v < 2; v++) {
+        free(outputs[v]);
+        free(intermediates[v]);
+    }
+    return match ? 0 : 1;
+}
@@ -0,0 +1,243 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+/*
+ * Particle batches for the transport-step tests, in two layouts.
+ *
+ * MCsquare's hot loop does not evaluate one function over one array: every
+ * step it updates position, direction, energy and weight of a whole batch
+ * together, under an alive mask, and periodically drops the dead particles.
+ * Each particle has PT_FIELDS doubles, stored either
+ *
+ *     SoA  field[f][i]                    one unit-stride array per field
+ *     AoS  records[i * PT_FIELDS + f]     one 64-byte record per particle
+ *
+ * The alive mask, and the per-step temporaries that array notation needs
+ * (step length, loss, deflection, deposit), are unit-stride arrays in both
+ * layouts. The step functions are the test's own (array notation in the Cilk
+ * test, omp simd loops in the OpenMP one); this header provides
+ * initialization, compaction and the benchmark driver.
+ * Both layouts perform the same arithmetic in the same order, so their
+ * tallies must be identical, and deposits are fixed point (DOSE_SCALE units)
+ * so the dose is exact whatever order the reduction adds it in.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "common.h"
+#include "bench.h"
+#include "perfcount.h"
+
+enum { PT_X, PT_Y, PT_Z, PT_U, PT_V, PT_W, PT_ENERGY, PT_WEIGHT, PT_FIELDS };
+
+#ifndef PARTICLE_BATCH
+#define PARTICLE_BATCH 4096
+#endif
+
+#define PT_STEP 0.1            // step length (cm) at high energy
+#define PT_E0 10.0             // energy (MeV) at which steps shrink
+#define PT_LOSS_WATER 2.0      // energy loss rate (MeV/cm) for z < PT_SLAB
+#define PT_LOSS_AIR 0.002      // and beyond it
+#define PT_SLAB 15.0           // depth (cm) of the water slab
+#define PT_DEPTH 20.0          // particles beyond this depth leave the grid
+#define PT_WIDTH 10.0          // and beyond this distance from the beam axis
+#define PT_SCATTER 0.5         // deflection scale in water
+#define PT_ATTENUATION 0.01    // weight lost to nuclear interactions (1/cm)
+#define PT_CUTOFF 0.5          // particles below this energy (MeV) stop
+#define PT_COMPACT_EVERY 8     // steps between compactions
+#define PT_MAX_STEPS 2000
+
+typedef struct {
+    int n;                      // particles in the batch, alive or not
+    int aos;
+    double *field[PT_FIELDS];   // SoA storage
+    double *records;            // AoS storage
+    double *step, *loss, *turn, *next_u;
+    int *units;                 // deposit of the step, DOSE_SCALE units (< 1 MeV)
+    int *alive;
+} particle_batch;
+
+typedef struct {
+    int steps;
+    long long particle_steps;   // batch slots processed, alive or not
+    long long dose;             // DOSE_SCALE units
+    int stopped;                // fell below PT_CUTOFF
+    int escaped;                // left the grid
+    long long escaped_energy;   // DOSE_SCALE units
+} particle_tally;
+
+// One transport step over b->n particles; deposits into t->dose
+typedef void (*particle_step_fn)(particle_batch *b, particle_tally *t);
+
+static inline void particles_alloc(particle_batch *b, int capacity, int aos) {
+    memset(b, 0, sizeof(*b));
+    b->aos = aos;
+    if (aos) {
+        b->records = test_alloc((size_t)capacity * PT_FIELDS, sizeof(double));
+    } else {
+        for (int f = 0; f < PT_FIELDS; f++) {
+            b->field[f] = test_alloc(capacity, sizeof(double));
+        }
+    }
+    b->step = test_alloc(capacity, sizeof(double));
+    b->loss = test_alloc(capacity, sizeof(double));
+    b->turn = test_alloc(capacity, sizeof(double));
+    b->next_u = test_alloc(capacity, sizeof(double));
+    b->units = test_alloc(capacity, sizeof(int));
+    b->alive = test_alloc(capacity, sizeof(int));
+}
+
+static inline void particles_free(particle_batch *b) {
+    free(b->records);
+    for (int f = 0; f < PT_FIELDS; f++) {
+        free(b->field[f]);
+    }
+    free(b->step);
+    free(b->loss);
+    free(b->turn);
+    free(b->next_u);
+    free(b->units);
+    free(b->alive);
+}
+
+static inline double *particle_field(particle_batch *b, int i, int f) {
+    return b->aos ? &b->records[(size_t)i * PT_FIELDS + f] : &b->field[f][i];
+}
+
+// Deterministic beam: 9-37 MeV, slightly divergent, entering at z = 0
+static inline void particles_init(particle_batch *b, int n) {
+    b->n = n;
+    for (int i = 0; i < n; i++) {
+        double a = TEST_INPUT[i % VLENGTH];
+        double c = 1e-2 * (double)((i / VLENGTH) % 97);
+        double u = 0.1 * (a - 0.45), v = 0.2 * (c - 0.48);
+        *particle_field(b, i, PT_X) = c;
+        *particle_field(b, i, PT_Y) = a - 0.45;
+        *particle_field(b, i, PT_Z) = 0.0;
+        *particle_field(b, i, PT_U) = u;
+        *particle_field(b, i, PT_V) = v;
+        *particle_field(b, i, PT_W) = sqrt(1.0 - u * u - v * v);
+        *particle_field(b, i, PT_ENERGY) = 5.0 + 40.0 * a + c;
+        *particle_field(b, i, PT_WEIGHT) = 1.0;
+        b->alive[i] = 1;
+    }
+}
+
+// Drops dead particles, keeping the order of the rest; counts how they died
+static inline void particles_compact(particle_batch *b, particle_tally *t) {
+    int kept = 0;
+    for (int i = 0; i < b->n; i++) {
+        if (!b->alive[i]) {
+            double energy = *particle_field(b, i, PT_ENERGY);
+            if (energy <= PT_CUTOFF) {
+                t->stopped++;
+            } else {
+                t->escaped++;
+                t->escaped_energy += (long long)(energy * *particle_field(b, i, PT_WEIGHT) * DOSE_SCALE);
+            }
+            continue;
+        }
+        if (kept < i) {
+            for (int f = 0; f < PT_FIELDS; f++) {
+                *particle_field(b, kept, f) = *particle_field(b, i, f);
+            }
+            b->alive[kept] = 1;
+        }
+        kept++;
+    }
+    b->n = kept;
+}
+
+// Transports a fresh batch of n particles until none is left
+static inline void particles_transport(particle_batch *b, particle_step_fn step, int n,
+                                       particle_tally *t) {
+    memset(t, 0, sizeof(*t));
+    particles_init(b, n);
+    while (b->n > 0 && t->steps < PT_MAX_STEPS) {
+        step(b, t);
+        t->particle_steps += b->n;
+        t->steps++;
+        if (t->steps % PT_COMPACT_EVERY == 0) {
+            particles_compact(b, t);
+        }
+    }
+    particles_compact(b, t);
+}
+
+static inline int particles_tally_equal(const particle_tally *a, const particle_tally *b) {
+    return a->steps == b->steps && a->particle_steps == b->particle_steps &&
+           a->dose == b->dose && a->stopped == b->stopped && a->escaped == b->escaped &&
+           a->escaped_energy == b->escaped_energy;
+}
+
+// PARTICLES_<layout>_N<n>_* results, BENCH_<layout>_N<n>_* per particle step
+// and, with -DPERF_COUNTERS, PERF_<layout>_N<n>_* over one more transport
+static inline void particles_benchmark(const char *layout, particle_step_fn step, int aos,
+                                       int n, particle_tally *t) {
+    particle_batch b;
+    particles_alloc(&b, n, aos);
+    particles_transport(&b, step, n, t);
+
+    char name[48];
+    snprintf(name, sizeof(name), "PARTICLES_%s_N%d", layout, n);
+    printf("%s_STEPS=%d\n", name, t->steps);
+    printf("%s_PARTICLE_STEPS=%lld\n", name, t->particle_steps);
+    printf("%s_STOPPED=%d\n", name, t->stopped);
+    printf("%s_ESCAPED=%d\n", name, t->escaped);
+    printf("%s_LEFT=%d\n", name, b.n);
+    printf("%s_DOSE_UNITS=%lld\n", name, t->dose);
+    printf("%s_ESCAPED_ENERGY_UNITS=%lld\n", name, t->escaped_energy);
+    printf("%s_DOSE_MEV=%.6f\n", name, (double)t->dose / DOSE_SCALE);
+
+    // Each sample transports a fresh batch; initialization is ~1% of it
+    particle_tally timed;
+    bench_run run;
+    bench_begin(&run, (double)t->particle_steps);
+    while (bench_next(&run)) {
+        particles_transport(&b, step, n, &timed);
+    }
+    bench_end(&run);
+    snprintf(name, sizeof(name), "BENCH_%s_N%d", layout, n);
+    bench_report(name, &run);
+
+#ifdef PERF_COUNTERS
+    perfcount_group perf;
+    perfcount_sample sample;
+    perfcount_open(&perf);
+    perfcount_start(&perf);
+    particles_transport(&b, step, n, &timed);
+    perfcount_stop(&perf, &sample, (double)t->particle_steps);
+    perfcount_close(&perf);
+    snprintf(name, sizeof(name), "PERF_%s_N%d", layout, n);
+    perfcount_report(name, &sample);
+#endif
+
+    particles_free(&b);
+}
+
+// Usage: <program> [N ...]; both layouts for each batch size
+static inline int particles_main(int argc, char **argv, particle_step_fn soa, particle_step_fn aos) {
+    int count = argc > 0 ? argc : 1;
+#ifdef PERF_COUNTERS
+    perfcount_group perf;
+    perfcount_open(&perf);
+    perfcount_status(&perf);
+    perfcount_close(&perf);
+#endif
+    int match = 1;
+    for (int s = 0; s < count; s++) {
+        int n = argc > 0 ? atoi(argv[s]) : PARTICLE_BATCH;
+        if (n <= 0) {
+            fprintf(stderr, "particles: invalid batch size '%s'\n", argv[s]);
+            return 1;
+        }
+        particle_tally t_soa, t_aos;
+        particles_benchmark("SOA", soa, 0, n, &t_soa);
+        particles_benchmark("AOS", aos, 1, n, &t_aos);
+        printf("PARTICLES_N%d_LAYOUTS_MATCH=%d\n", n, particles_tally_equal(&t_soa, &t_aos));
+        match &= particles_tally_equal(&t_soa, &t_aos);
+    }
+    return match ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,218 @@
+#ifndef PERFCOUNT_H
+#define PERFCOUNT_H
+
+/*
+ * Hardware performance counters per pattern block, through perf_event_open.
+ *
+ * Timing says that a converted kernel got slower, not why. Built with
+ * -DPERF_COUNTERS, the test programs run each pattern block again after the
+ * timed samples under the counters below and print them per element next to
+ * TIMING_MS:
+ *
+ *     CYCLES, INSTRUCTIONS, IPC     how long, and how much work
+ *     FP_SCALAR, FP_PACKED          retired scalar / packed (128/256/512-bit)
+ *                                   double instructions: lost vectorization
+ *                                   shows as FP_PACKED turning into FP_SCALAR
+ *     L1D_MISSES, LLC_MISSES        cache behaviour of the block
+ *     BRANCH_MISSES                 e.g. a masked block compiled to branches
+ *
+ *     perfcount_group perf;
+ *     perfcount_sample sample;
+ *     perfcount_open(&perf);
+ *     perfcount_status(&perf);
+ *     perfcount_start(&perf);
+ *     ... block, repeated ...
+ *     perfcount_stop(&perf, &sample, elements);
+ *     perfcount_report("PERF_A", &sample);
+ *     perfcount_close(&perf);
+ *
+ * Only user-space events of the calling thread are counted. Events are opened
+ * one by one rather than as a group, so the kernel multiplexes them when the
+ * PMU has fewer counters, and counts are scaled by enabled/running time like
+ * perf stat. FP_SCALAR/FP_PACKED are Intel's FP_ARITH_INST_RETIRED (Broadwell
+ * and later); elsewhere they are reported n/a unless PERFCOUNT_FP_SCALAR_RAW
+ * and PERFCOUNT_FP_PACKED_RAW give raw event codes for the PMU. Any event the
+ * kernel refuses (no PMU in a VM, perf_event_paranoid > 2) is reported n/a;
+ * without Linux every event is.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+enum {
+    PERFCOUNT_CYCLES,
+    PERFCOUNT_INSTRUCTIONS,
+    PERFCOUNT_FP_SCALAR,
+    PERFCOUNT_FP_PACKED,
+    PERFCOUNT_L1D_MISSES,
+    PERFCOUNT_LLC_MISSES,
+    PERFCOUNT_BRANCH_MISSES,
+    PERFCOUNT_EVENTS
+};
+
+static const char *const PERFCOUNT_NAMES[PERFCOUNT_EVENTS] = {
+    "CYCLES", "INSTRUCTIONS", "FP_SCALAR", "FP_PACKED",
+    "L1D_MISSES", "LLC_MISSES", "BRANCH_MISSES",
+};
+
+typedef struct {
+    int fd[PERFCOUNT_EVENTS];   // -1 where the event is unavailable
+    int opened;
+    int error;                  // errno of the first event that failed to open
+} perfcount_group;
+
+typedef struct {
+    double count[PERFCOUNT_EVENTS];  // scaled totals, -1 where unavailable
+    double elements;
+} perfcount_sample;
+
+#if defined(__x86_64__) || defined(__i386__)
+static inline int perfcount_is_intel(void) {
+    unsigned a, b, c, d;
+    // "GenuineIntel" in ebx, edx, ecx
+    return __get_cpuid(0, &a, &b, &c, &d) && b == 0x756e6547 && d == 0x49656e69 && c == 0x6c65746e;
+}
+#else
+static inline int perfcount_is_intel(void) { return 0; }
+#endif
+
+// FP_ARITH_INST_RETIRED (event 0xc7): umask 0x01 scalar double, 0x54 packed double
+#ifndef PERFCOUNT_FP_SCALAR_RAW
+#define PERFCOUNT_FP_SCALAR_RAW (perfcount_is_intel() ? 0x01c7 : 0)
+#endif
+#ifndef PERFCOUNT_FP_PACKED_RAW
+#define PERFCOUNT_FP_PACKED_RAW (perfcount_is_intel() ? 0x54c7 : 0)
+#endif
+
+#ifdef __linux__
+static inline uint64_t perfcount_cache_miss(uint64_t cache) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+static inline int perfcount_event(int event, struct perf_event_attr *attr) {
+    memset(attr, 0, sizeof(*attr));
+    attr->size = sizeof(*attr);
+    attr->type = PERF_TYPE_HARDWARE;
+    switch (event) {
+    case PERFCOUNT_CYCLES:        attr->config = PERF_COUNT_HW_CPU_CYCLES; break;
+    case PERFCOUNT_INSTRUCTIONS:  attr->config = PERF_COUNT_HW_INSTRUCTIONS; break;
+    case PERFCOUNT_BRANCH_MISSES: attr->config = PERF_COUNT_HW_BRANCH_MISSES; break;
+    case PERFCOUNT_FP_SCALAR:
+    case PERFCOUNT_FP_PACKED:
+        attr->type = PERF_TYPE_RAW;
+        attr->config = event == PERFCOUNT_FP_SCALAR ? PERFCOUNT_FP_SCALAR_RAW : PERFCOUNT_FP_PACKED_RAW;
+        if (!attr->config) return 0;
+        break;
+    case PERFCOUNT_L1D_MISSES:
+        attr->type = PERF_TYPE_HW_CACHE;
+        attr->config = perfcount_cache_miss(PERF_COUNT_HW_CACHE_L1D);
+        break;
+    case PERFCOUNT_LLC_MISSES:
+        attr->type = PERF_TYPE_HW_CACHE;
+        attr->config = perfcount_cache_miss(PERF_COUNT_HW_CACHE_LL);
+        break;
+    }
+    attr->disabled = 1;
+    attr->exclude_kernel = 1;
+    attr->exclude_hv = 1;
+    attr->read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return 1;
+}
+#endif
+
+static inline void perfcount_open(perfcount_group *g) {
+    g->opened = 0;
+    g->error = ENOSYS;
+    for (int e = 0; e < PERFCOUNT_EVENTS; e++) {
+        g->fd[e] = -1;
+#ifdef __linux__
+        struct perf_event_attr attr;
+        if (!perfcount_event(e, &attr)) continue;
+        g->fd[e] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (g->fd[e] >= 0) {
+            g->opened++;
+        } else if (g->opened == 0) {
+            g->error = errno;
+        }
+#endif
+    }
+}
+
+static inline void perfcount_start(perfcount_group *g) {
+#ifdef __linux__
+    for (int e = 0; e < PERFCOUNT_EVENTS; e++) {
+        if (g->fd[e] >= 0) ioctl(g->fd[e], PERF_EVENT_IOC_RESET, 0);
+    }
+    for (int e = 0; e < PERFCOUNT_EVENTS; e++) {
+        if (g->fd[e] >= 0) ioctl(g->fd[e], PERF_EVENT_IOC_ENABLE, 0);
+    }
+#else
+    (void)g;
+#endif
+}
+
+static inline void perfcount_stop(perfcount_group *g, perfcount_sample *s, double elements) {
+#ifdef __linux__
+    for (int e = 0; e < PERFCOUNT_EVENTS; e++) {
+        if (g->fd[e] >= 0) ioctl(g->fd[e], PERF_EVENT_IOC_DISABLE, 0);
+    }
+#endif
+    s->elements = elements;
+    for (int e = 0; e < PERFCOUNT_EVENTS; e++) {
+        s->count[e] = -1.0;
+#ifdef __linux__
+        uint64_t value[3];  // count, time enabled, time running
+        if (g->fd[e] < 0 || read(g->fd[e], value, sizeof(value)) != sizeof(value)) continue;
+        s->count[e] = value[2] ? (double)value[0] * ((double)value[1] / (double)value[2]) : 0.0;
+#endif
+    }
+}
+
+static inline void perfcount_close(perfcount_group *g) {
+#ifdef __linux__
+    for (int e = 0; e < PERFCOUNT_EVENTS; e++) {
+        if (g->fd[e] >= 0) close(g->fd[e]);
+    }
+#endif
+    g->opened = 0;
+}
+
+// PERF_COUNTERS=<opened>/<events>, and why when none opened
+static inline void perfcount_status(const perfcount_group *g) {
+    printf("PERF_COUNTERS=%d/%d\n", g->opened, PERFCOUNT_EVENTS);
+    if (g->opened == 0) {
+        printf("PERF_COUNTERS_ERROR=%s\n", strerror(g->error));
+    }
+}
+
+// <name>_<EVENT>_PER_ELEM for every event and <name>_IPC; n/a where unavailable
+static inline void perfcount_report(const char *name, const perfcount_sample *s) {
+    for (int e = 0; e < PERFCOUNT_EVENTS; e++) {
+        if (s->count[e] < 0) {
+            printf("%s_%s_PER_ELEM=n/a\n", name, PERFCOUNT_NAMES[e]);
+        } else {
+            printf("%s_%s_PER_ELEM=%.4f\n", name, PERFCOUNT_NAMES[e], s->count[e] / s->elements);
+        }
+    }
+    const double *c = s->count;
+    if (c[PERFCOUNT_CYCLES] > 0 && c[PERFCOUNT_INSTRUCTIONS] >= 0) {
+        printf("%s_IPC=%.3f\n", name, c[PERFCOUNT_INSTRUCTIONS] / c[PERFCOUNT_CYCLES]);
+    } else {
+        printf("%s_IPC=n/a\n", name);
+    }
+}
+
+#endif
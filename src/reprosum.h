@@ -0,0 +1,47 @@
+#ifndef REPROSUM_H
+#define REPROSUM_H
+
+/*
+ * Reproducible double sums for bit-for-bit regression tests across machines.
+ *
+ * "#pragma omp simd reduction(+:sum)" lets the compiler keep one partial sum
+ * per vector lane, so the result changes with the vector width (AVX2 vs
+ * AVX-512) and, in a parallel loop, with the thread count. Here element i
+ * always goes to partial sum i % REPRO_LANES, every partial sum adds its
+ * elements in index order, and repro_combine() adds the partial sums in a
+ * fixed pairwise order. The loop over lanes carries no reduction, so
+ * vectorizing it at any width reorders nothing: every ISA, and scalar code,
+ * produces the same bits.
+ *
+ *     double sum = repro_sum(output, n);
+ *
+ * The converter's --repro-sum mode emits the same loops inline for
+ * __sec_reduce_add over any double expression. FMA contraction changes the
+ * rounding of a product added to a lane, so compare builds for targets that
+ * differ in FMA support with -ffp-contract=off.
+ */
+
+#define REPRO_LANES 8
+
+// ((0+4)+(2+6)) + ((1+5)+(3+7)), the order of vd8_reduce_add() in vec.h
+static inline double repro_combine(const double lanes[REPRO_LANES]) {
+    return ((lanes[0] + lanes[4]) + (lanes[2] + lanes[6])) +
+           ((lanes[1] + lanes[5]) + (lanes[3] + lanes[7]));
+}
+
+static inline double repro_sum(const double *x, int n) {
+    double lanes[REPRO_LANES] = {0};
+    int i = 0;
+    for (; i + REPRO_LANES <= n; i += REPRO_LANES) {
+        #pragma omp simd
+        for (int k = 0; k < REPRO_LANES; k++) {
+            lanes[k] += x[i + k];
+        }
+    }
+    for (int k = 0; i < n; i++, k++) {
+        lanes[k] += x[i];
+    }
+    return repro_combine(lanes);
+}
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef SCALING_H
+#define SCALING_H
+
+/*
+ * Threaded kernels for the scaling runner (scaling_runner.c)
+ *
+ * Patterns A, A2 and B over input[0:n], as in kernels.h, split across
+ * threads. The runner links one runtime's file and times each of its
+ * variants at the thread count and placement the environment selects:
+ *   scaling_cilk.c    GCC 7 -fcilkplus: _Cilk_for over blocks (cilk-for)
+ *                     and _Cilk_spawn halving down to one block (cilk-spawn),
+ *                     CILK_NWORKERS workers
+ *   scaling_openmp.c  -fopenmp: their conversions, omp parallel for
+ *                     schedule(dynamic) (openmp-for) and omp task
+ *                     (openmp-tasks), plus the one parallel for simd loop
+ *                     --fuse --parallel-threshold makes of kernel_cilk
+ *                     (openmp-parallel); OMP_NUM_THREADS, OMP_PROC_BIND
+ *                     and OMP_PLACES
+ *
+ * The block variants reduce each SCALING_BLOCK elements into their own
+ * kernel_result and combine the blocks in order, so their results do not
+ * depend on the thread count. openmp-parallel reduces per thread and differs
+ * from them by rounding.
+ *
+ * Pages belong to the NUMA node of the thread that first writes them.
+ * scaling_first_touch() therefore fills the buffers with the runtime's
+ * threads, in the same static partition as openmp-parallel; the dynamic
+ * and work-stealing variants hand blocks to whichever thread is free, so
+ * for them first touch only spreads the pages across nodes.
+ */
+
+#include "kernels.h"
+
+#ifndef SCALING_BLOCK
+#define SCALING_BLOCK 16384  // elements per block; 128 KB of each double array
+#endif
+
+typedef struct {
+    const char *name;
+    kernel_fn kernel;
+} scaling_variant;
+
+// Defined by scaling_cilk.c or scaling_openmp.c
+extern const char scaling_runtime[];  // "cilk" or "openmp"
+extern const char scaling_compiler[];
+extern const scaling_variant scaling_variants[];
+extern const int scaling_num_variants;
+
+// Threads the runtime runs parallel regions with
+int scaling_threads(void);
+
+// test_fill() and zeroed outputs, written by the threads that will use them
+void scaling_first_touch(int n, double *input, int *flags, double *output, double *intermediate);
+
+// Arguments of one block kernel call; partial has one entry per block
+typedef struct {
+    int n;
+    const double *input;
+    const int *flags;
+    double *output;
+    double *intermediate;
+    kernel_result *partial;
+} scaling_args;
+
+static inline int scaling_blocks(int n) {
+    return (n + SCALING_BLOCK - 1) / SCALING_BLOCK;
+}
+
+// Block b: its first element and length
+static inline int scaling_block_start(int b) {
+    return b * SCALING_BLOCK;
+}
+
+static inline int scaling_block_length(int n, int b) {
+    int rest = n - b * SCALING_BLOCK;
+    return rest < SCALING_BLOCK ? rest : SCALING_BLOCK;
+}
+
+// Sums the block results in block order
+static inline void scaling_combine(const kernel_result *partial, int blocks, kernel_result *result) {
+    result->count = 0;
+    result->sum = 0.0;
+    result->sum2 = 0.0;
+    for (int b = 0; b < blocks; b++) {
+        result->count += partial[b].count;
+        result->sum += partial[b].sum;
+        result->sum2 += partial[b].sum2;
+    }
+}
+
+#endif
@@ -0,0 +1,88 @@
+/*
+ * Cilk Plus threaded kernels for the scaling runner
+ * Requires: GCC 7.x with -fcilkplus flag, linked with -lcilkrts
+ *
+ * The worker count follows CILK_NWORKERS. The work-stealing runtime has no
+ * thread placement settings; it runs as the OS schedules its workers.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <cilk/cilk_api.h>
+#include "scaling.h"
+
+const char scaling_runtime[] = "cilk";
+const char scaling_compiler[] = __VERSION__;
+
+int scaling_threads(void) {
+    return __cilkrts_get_nworkers();
+}
+
+void scaling_first_touch(int n, double *input, int *flags, double *output, double *intermediate) {
+    _Cilk_for (int b = 0; b < scaling_blocks(n); b++) {
+        int lo = scaling_block_start(b), len = scaling_block_length(n, b);
+        test_fill_range(input, flags, lo, lo + len);
+        memset(output + lo, 0, sizeof(double) * len);
+        memset(intermediate + lo, 0, sizeof(double) * len);
+    }
+}
+
+// Patterns A, A2 and B over block b
+static void block_kernel(const scaling_args *a, int b) {
+    int lo = scaling_block_start(b), len = scaling_block_length(a->n, b);
+    const double *input = a->input;
+    const int *flags = a->flags;
+    double *output = a->output, *intermediate = a->intermediate;
+
+    output[lo:len] = -log(input[lo:len]) * 2.0;
+    intermediate[lo:len] = exp(-input[lo:len]) / (input[lo:len] + 0.1);
+
+    int count = __sec_reduce_add(flags[lo:len]);
+    double sum = __sec_reduce_add(output[lo:len]);
+    double sum2 = __sec_reduce_add(intermediate[lo:len]);
+
+    a->partial[b].count = count;
+    a->partial[b].sum = sum;
+    a->partial[b].sum2 = sum2;
+}
+
+static void kernel_cilk_for(int n, const double *input, const int *flags,
+                            double *output, double *intermediate, kernel_result *result) {
+    int blocks = scaling_blocks(n);
+    kernel_result partial[blocks];
+    scaling_args a = {n, input, flags, output, intermediate, partial};
+
+    _Cilk_for (int b = 0; b < blocks; b++) {
+        block_kernel(&a, b);
+    }
+    scaling_combine(partial, blocks, result);
+}
+
+// Blocks lo..hi-1, halved until one block is left
+static void range_kernel(const scaling_args *a, int lo, int hi) {
+    if (hi - lo == 1) {
+        block_kernel(a, lo);
+        return;
+    }
+    int mid = lo + (hi - lo) / 2;
+    _Cilk_spawn range_kernel(a, lo, mid);
+    range_kernel(a, mid, hi);
+    _Cilk_sync;
+}
+
+static void kernel_cilk_spawn(int n, const double *input, const int *flags,
+                              double *output, double *intermediate, kernel_result *result) {
+    int blocks = scaling_blocks(n);
+    kernel_result partial[blocks];
+    scaling_args a = {n, input, flags, output, intermediate, partial};
+
+    range_kernel(&a, 0, blocks);
+    scaling_combine(partial, blocks, result);
+}
+
+const scaling_variant scaling_variants[] = {
+    { "cilk-for", kernel_cilk_for },
+    { "cilk-spawn", kernel_cilk_spawn },
+};
+
+const int scaling_num_variants = (int)(sizeof(scaling_variants) / sizeof(scaling_variants[0]));
@@ -0,0 +1,138 @@
+/*
+ * OpenMP threaded kernels for the scaling runner
+ * Requires: Any modern compiler with OpenMP support (-fopenmp)
+ *
+ * openmp-for and openmp-tasks are the converter's output for scaling_cilk.c:
+ * _Cilk_for becomes omp parallel for schedule(dynamic), _Cilk_spawn an omp
+ * task under parallel + single. openmp-parallel is kernel_cilk converted
+ * with --fuse --parallel-threshold, one parallel for simd loop, with the
+ * default static schedule spelled out: it gives every thread the one
+ * contiguous range scaling_first_touch() placed on its node.
+ *
+ * The thread count follows OMP_NUM_THREADS and the placement OMP_PROC_BIND
+ * and OMP_PLACES.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <omp.h>
+#include "scaling.h"
+
+const char scaling_runtime[] = "openmp";
+const char scaling_compiler[] = __VERSION__;
+
+int scaling_threads(void) {
+    return omp_get_max_threads();
+}
+
+void scaling_first_touch(int n, double *input, int *flags, double *output, double *intermediate) {
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; i++) {
+        test_fill_range(input, flags, i, i + 1);
+        output[i] = 0.0;
+        intermediate[i] = 0.0;
+    }
+}
+
+// Patterns A, A2 and B over block b
+static void block_kernel(const scaling_args *a, int b) {
+    int lo = scaling_block_start(b), len = scaling_block_length(a->n, b);
+    const double *input = a->input;
+    const int *flags = a->flags;
+    double *output = a->output, *intermediate = a->intermediate;
+
+    #pragma omp simd
+    for (int i = 0; i < len; i++) {
+        output[lo + i] = -log(input[lo + i]) * 2.0;
+    }
+    #pragma omp simd
+    for (int i = 0; i < len; i++) {
+        intermediate[lo + i] = exp(-input[lo + i]) / (input[lo + i] + 0.1);
+    }
+
+    int count = 0;
+    #pragma omp simd reduction(+:count)
+    for (int i = 0; i < len; i++) {
+        count += flags[lo + i];
+    }
+    double sum = 0;
+    #pragma omp simd reduction(+:sum)
+    for (int i = 0; i < len; i++) {
+        sum += output[lo + i];
+    }
+    double sum2 = 0;
+    #pragma omp simd reduction(+:sum2)
+    for (int i = 0; i < len; i++) {
+        sum2 += intermediate[lo + i];
+    }
+
+    a->partial[b].count = count;
+    a->partial[b].sum = sum;
+    a->partial[b].sum2 = sum2;
+}
+
+static void kernel_openmp_for(int n, const double *input, const int *flags,
+                              double *output, double *intermediate, kernel_result *result) {
+    int blocks = scaling_blocks(n);
+    kernel_result partial[blocks];
+    scaling_args a = {n, input, flags, output, intermediate, partial};
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int b = 0; b < blocks; b++) {
+        block_kernel(&a, b);
+    }
+    scaling_combine(partial, blocks, result);
+}
+
+// Blocks lo..hi-1, halved until one block is left
+static void range_kernel(const scaling_args *a, int lo, int hi) {
+    if (hi - lo == 1) {
+        block_kernel(a, lo);
+        return;
+    }
+    int mid = lo + (hi - lo) / 2;
+    #pragma omp task
+    range_kernel(a, lo, mid);
+    range_kernel(a, mid, hi);
+    #pragma omp taskwait
+}
+
+static void kernel_openmp_tasks(int n, const double *input, const int *flags,
+                                double *output, double *intermediate, kernel_result *result) {
+    int blocks = scaling_blocks(n);
+    kernel_result partial[blocks];
+    scaling_args a = {n, input, flags, output, intermediate, partial};
+
+    // The spawn tree runs under parallel + single, as Cilk's workers would
+    #pragma omp parallel
+    #pragma omp single
+    range_kernel(&a, 0, blocks);
+    scaling_combine(partial, blocks, result);
+}
+
+static void kernel_openmp_parallel(int n, const double *input, const int *flags,
+                                   double *output, double *intermediate, kernel_result *result) {
+    int count = 0;
+    double sum = 0;
+    double sum2 = 0;
+    #pragma omp parallel for simd schedule(static) reduction(+:count,sum,sum2)
+    for (int i = 0; i < n; i++) {
+        output[i] = -log(input[i]) * 2.0;
+        intermediate[i] = exp(-input[i]) / (input[i] + 0.1);
+        count += flags[i];
+        sum += output[i];
+        sum2 += intermediate[i];
+    }
+
+    result->count = count;
+    result->sum = sum;
+    result->sum2 = sum2;
+}
+
+const scaling_variant scaling_variants[] = {
+    { "openmp-for", kernel_openmp_for },
+    { "openmp-tasks", kernel_openmp_tasks },
+    { "openmp-parallel", kernel_openmp_parallel },
+};
+
+const int scaling_num_variants = (int)(sizeof(scaling_variants) / sizeof(scaling_variants[0]));
@@ -0,0 +1,96 @@
+/*
+ * Thread scaling benchmark of the threaded kernels (scaling.h)
+ *
+ * Built once per runtime, with that runtime's kernels:
+ *   gcc-7 -fcilkplus -O2 -o scaling_cilk src/scaling_runner.c src/scaling_cilk.c -lcilkrts -lm
+ *   gcc -fopenmp -O2 -o scaling_openmp src/scaling_runner.c src/scaling_openmp.c -lm
+ * A run measures the thread count and placement its environment selects;
+ * scripts/scaling.py sweeps them and computes speedup and efficiency.
+ *
+ * Each size gets fresh buffers, first touched by the runtime's threads, and
+ * every variant is timed on them with bench_kernel(). Results are CSV, one
+ * row per variant and size, with the placement variables as given (empty
+ * when unset) and the largest element difference from the first variant.
+ *
+ * Usage: scaling_runner [N ...]   sizes, default SCALING_SIZES
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "common.h"
+#include "bench.h"
+#include "scaling.h"
+
+// Sizes well past the LLC, where bandwidth and page placement matter
+#ifndef SCALING_SIZES
+#define SCALING_SIZES 1048576, 8388608
+#endif
+
+static double max_abs_diff(const double *a, const double *b, int n) {
+    double worst = 0.0;
+    for (int i = 0; i < n; i++) {
+        double d = fabs(a[i] - b[i]);
+        if (d > worst) worst = d;
+    }
+    return worst;
+}
+
+static const char *env_or_empty(const char *name) {
+    const char *value = getenv(name);
+    return value ? value : "";
+}
+
+int main(int argc, char **argv) {
+    static const int default_sizes[] = { SCALING_SIZES };
+    int num_sizes = argc > 1 ? argc - 1 : (int)(sizeof(default_sizes) / sizeof(default_sizes[0]));
+    int threads = scaling_threads();
+    const char *bind = env_or_empty("OMP_PROC_BIND");
+    const char *places = env_or_empty("OMP_PLACES");
+
+    printf("runtime,variant,compiler,threads,proc_bind,places,n,reps,min_ns,median_ns,p99_ns,"
+           "melem_per_s,count,sum,sum2,max_abs_diff\n");
+
+    for (int s = 0; s < num_sizes; s++) {
+        int n = argc > 1 ? atoi(argv[s + 1]) : default_sizes[s];
+        if (n <= 0) {
+            fprintf(stderr, "scaling_runner: invalid size '%s'\n", argv[s + 1]);
+            return 1;
+        }
+
+        // aligned_alloc leaves large buffers untouched, so first touch places them
+        double *input = test_alloc(n, sizeof(double));
+        int *flags = test_alloc(n, sizeof(int));
+        double *output = test_alloc(n, sizeof(double));
+        double *intermediate = test_alloc(n, sizeof(double));
+        double *ref_output = test_alloc(n, sizeof(double));
+        double *ref_intermediate = test_alloc(n, sizeof(double));
+        scaling_first_touch(n, input, flags, output, intermediate);
+
+        for (int v = 0; v < scaling_num_variants; v++) {
+            bench_run run;
+            kernel_result result;
+            bench_kernel(&run, scaling_variants[v].kernel, n, input, flags, output, intermediate, &result);
+
+            if (v == 0) {
+                memcpy(ref_output, output, sizeof(double) * n);
+                memcpy(ref_intermediate, intermediate, sizeof(double) * n);
+            }
+            double diff = fmax(max_abs_diff(output, ref_output, n),
+                               max_abs_diff(intermediate, ref_intermediate, n));
+
+            printf("%s,%s,\"%s\",%d,\"%s\",\"%s\",%d,%d,%.4f,%.4f,%.4f,%.2f,%d,%.17g,%.17g,%.3g\n",
+                   scaling_runtime, scaling_variants[v].name, scaling_compiler, threads, bind, places,
+                   n, run.reps, run.min_ns, run.median_ns, run.p99_ns, 1e3 / run.median_ns,
+                   result.count, result.sum, result.sum2, diff);
+        }
+
+        free(input);
+        free(flags);
+        free(output);
+        free(intermediate);
+        free(ref_output);
+        free(ref_intermediate);
+    }
+    return 0;
+}
@@ -0,0 +1,116 @@
+#ifndef TEMPORARIES_H
+#define TEMPORARIES_H
+
+/*
+ * Section temporaries of a per-step kernel, for the arena tests.
+ *
+ * A diffusion step computes a flux per element and spreads it to both
+ * neighbours through shifted sections, so its two temporaries live across
+ * statements of different extents and neither fusion nor scalar replacement
+ * removes them. Each call needs 2 * n doubles of scratch, and a transport
+ * loop calls it once per step. The tests time where that scratch comes
+ * from: a stack VLA (the Cilk reference), malloc/free per call, or the
+ * thread's arena (arena.h).
+ *
+ * A sample repeats the step until it has covered at least TEMPS_MIN_ELEMENTS
+ * elements, so the allocation cost shows at small n instead of being lost in
+ * timer resolution. With the default TEMPS_SIZES the VLAs, at most 1 MB, fit
+ * the 8 MB main-thread stack; from about 512K elements they do not, and the
+ * VLA variants crash where the others keep running.
+ */
+
+#include <string.h>
+#include "common.h"
+#include "bench.h"
+
+#ifndef TEMPS_SIZES
+#define TEMPS_SIZES 64, 4096, 65536
+#endif
+
+#ifndef TEMPS_MIN_ELEMENTS
+#define TEMPS_MIN_ELEMENTS 65536
+#endif
+
+#define TEMPS_DT 0.1  // diffusion time step
+
+// One diffusion step: out[0:n] from in[0:n]
+typedef void (*temps_fn)(const double *in, double *out, int n);
+
+typedef struct {
+    const char *name;  // BENCH_<name>_N<n>_*
+    temps_fn step;
+} temps_variant;
+
+static inline void temps_init(double *in, int n) {
+    for (int i = 0; i < n; i++) {
+        in[i] = (double)(i % 97) / 97.0;
+    }
+}
+
+static inline void temps_time(const temps_variant *v, const double *in, double *out, int n) {
+    int calls = n < TEMPS_MIN_ELEMENTS ? (TEMPS_MIN_ELEMENTS + n - 1) / n : 1;
+    char name[48];
+    snprintf(name, sizeof(name), "BENCH_%s_N%d", v->name, n);
+    bench_run run;
+    bench_begin(&run, (double)calls * n);
+    while (bench_next(&run)) {
+        for (int c = 0; c < calls; c++) {
+            v->step(in, out, n);
+        }
+    }
+    bench_end(&run);
+    bench_report(name, &run);
+}
+
+// TEMPS_N<n>_{MEAN,MAX} of the first variant's step, TEMPS_N<n>_VARIANTS_MATCH
+// when there are several (all must produce the same bits), BENCH_* per element
+static inline int temps_benchmark(const temps_variant *variants, int count, int n) {
+    double *in = test_alloc(n, sizeof(double));
+    double *ref = test_alloc(n, sizeof(double));
+    double *out = test_alloc(n, sizeof(double));
+    temps_init(in, n);
+
+    variants[0].step(in, ref, n);
+    double sum = 0.0, max = ref[0];
+    for (int i = 0; i < n; i++) {
+        sum += ref[i];
+        max = ref[i] > max ? ref[i] : max;
+    }
+    printf("TEMPS_N%d_MEAN=%.17g\n", n, sum / n);
+    printf("TEMPS_N%d_MAX=%.17g\n", n, max);
+
+    int match = 1;
+    for (int v = 1; v < count; v++) {
+        variants[v].step(in, out, n);
+        match &= memcmp(out, ref, sizeof(double) * n) == 0;
+    }
+    if (count > 1) {
+        printf("TEMPS_N%d_VARIANTS_MATCH=%d\n", n, match);
+    }
+
+    for (int v = 0; v < count; v++) {
+        temps_time(&variants[v], in, out, n);
+    }
+    free(in);
+    free(ref);
+    free(out);
+    return match;
+}
+
+// Usage: <program> [N ...]; default TEMPS_SIZES
+static inline int temps_main(int argc, char **argv, const temps_variant *variants, int count) {
+    static const int sizes[] = {TEMPS_SIZES};
+    int runs = argc > 0 ? argc : (int)(sizeof(sizes) / sizeof(sizes[0]));
+    int match = 1;
+    for (int s = 0; s < runs; s++) {
+        int n = argc > 0 ? atoi(argv[s]) : sizes[s];
+        if (n < 2) {
+            fprintf(stderr, "temporaries: invalid size '%s', need at least 2 elements\n", argv[s]);
+            return 1;
+        }
+        match &= temps_benchmark(variants, count, n);
+    }
+    return match ? 0 : 1;
+}
+
+#endif
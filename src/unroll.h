@@ -0,0 +1,25 @@
+#ifndef UNROLL_H
+#define UNROLL_H
+
+/*
+ * Full unrolling of loops over a compile-time extent, for the converter's
+ * --unroll-constant output.
+ *
+ *     UNROLL(VLENGTH)
+ *     for (int i = 0; i < VLENGTH; i++) {
+ *         output[i] = -log(input[i]) * 2.0;
+ *     }
+ *
+ * UNROLL(n) is "#pragma GCC unroll n" with n macro-expanded first, which the
+ * pragma itself does not do, so the unroll factor follows -DVLENGTH. With a
+ * trip count equal to n the loop becomes straight-line code. GCC 12 rejects
+ * the pragma next to "#pragma omp simd", before or after it, so a loop is
+ * either unrolled or vectorized: the converter unrolls the loops that make
+ * scalar calls, which omp simd cannot vectorize without a vector math
+ * library, and leaves the rest omp simd loops.
+ */
+
+#define UNROLL_PRAGMA_(text) _Pragma(#text)
+#define UNROLL(n) UNROLL_PRAGMA_(GCC unroll n)
+
+#endif
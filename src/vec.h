@@ -0,0 +1,235 @@
+#ifndef VEC_H
+#define VEC_H
+
+/*
+ * Portable 8-wide double vectors for VLENGTH-sized sections.
+ *
+ * Code written against vdouble8 compiles to SIMD instructions whatever the
+ * compiler's vectorizer decides, which is what the converter's --backend vec
+ * output relies on. The implementation is picked from the target flags:
+ *
+ *   AVX-512F         one __m512d              (-mavx512f, -march=native)
+ *   AVX / AVX2       two __m256d              (-mavx2)
+ *   NEON (AArch64)   four float64x2_t
+ *   otherwise        a plain array of 8 doubles
+ *
+ * VEC_BACKEND names the one in use. Loads and stores are unaligned, so any
+ * double array of at least VEC_WIDTH elements works. Arithmetic is IEEE
+ * elementwise and matches scalar code bit for bit; vd8_reduce_add() sums in
+ * the same pairwise order on every backend.
+ *
+ * vd8_log() and vd8_exp() call libm per lane, unless VECMATH_LIBMVEC or
+ * VECMATH_SLEEF selects the vector-ABI entry points as in vecmath.h (x86
+ * only; link with -lmvec or -lsleefgnuabi).
+ */
+
+#include <math.h>
+
+#define VEC_WIDTH 8
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+#define VEC_BACKEND "avx512"
+typedef struct { __m512d v; } vdouble8;
+#elif defined(__AVX__)
+#include <immintrin.h>
+#define VEC_BACKEND "avx2"
+typedef struct { __m256d lo, hi; } vdouble8;
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define VEC_BACKEND "neon"
+typedef struct { float64x2_t v[4]; } vdouble8;
+#else
+#define VEC_BACKEND "scalar"
+typedef struct { double v[VEC_WIDTH]; } vdouble8;
+#endif
+
+#if (defined(VECMATH_LIBMVEC) || defined(VECMATH_SLEEF)) && defined(__AVX512F__)
+#define VEC_VECTOR_MATH 1
+__m512d _ZGVeN8v_log(__m512d);
+__m512d _ZGVeN8v_exp(__m512d);
+#elif (defined(VECMATH_LIBMVEC) || defined(VECMATH_SLEEF)) && defined(__AVX2__)
+#define VEC_VECTOR_MATH 1
+__m256d _ZGVdN4v_log(__m256d);
+__m256d _ZGVdN4v_exp(__m256d);
+#endif
+
+#if defined(__AVX512F__)
+
+static inline vdouble8 vd8_load(const double *p) { vdouble8 r = { _mm512_loadu_pd(p) }; return r; }
+static inline void vd8_store(double *p, vdouble8 a) { _mm512_storeu_pd(p, a.v); }
+static inline vdouble8 vd8_set1(double x) { vdouble8 r = { _mm512_set1_pd(x) }; return r; }
+static inline vdouble8 vd8_add(vdouble8 a, vdouble8 b) { vdouble8 r = { _mm512_add_pd(a.v, b.v) }; return r; }
+static inline vdouble8 vd8_sub(vdouble8 a, vdouble8 b) { vdouble8 r = { _mm512_sub_pd(a.v, b.v) }; return r; }
+static inline vdouble8 vd8_mul(vdouble8 a, vdouble8 b) { vdouble8 r = { _mm512_mul_pd(a.v, b.v) }; return r; }
+static inline vdouble8 vd8_div(vdouble8 a, vdouble8 b) { vdouble8 r = { _mm512_div_pd(a.v, b.v) }; return r; }
+static inline vdouble8 vd8_sqrt(vdouble8 a) { vdouble8 r = { _mm512_sqrt_pd(a.v) }; return r; }
+static inline vdouble8 vd8_fabs(vdouble8 a) { vdouble8 r = { _mm512_abs_pd(a.v) }; return r; }
+
+// Sign flip rather than 0 - a, so -(+0.0) is -0.0 as in scalar code
+static inline vdouble8 vd8_neg(vdouble8 a) {
+    __m512i sign = _mm512_set1_epi64((long long)0x8000000000000000ULL);
+    vdouble8 r = { _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(a.v), sign)) };
+    return r;
+}
+
+static inline double vd8_reduce_add(vdouble8 a) {
+    __m256d s = _mm256_add_pd(_mm512_castpd512_pd256(a.v), _mm512_extractf64x4_pd(a.v, 1));
+    __m128d t = _mm_add_pd(_mm256_castpd256_pd128(s), _mm256_extractf128_pd(s, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(t, _mm_unpackhi_pd(t, t)));
+}
+
+#ifdef VEC_VECTOR_MATH
+static inline vdouble8 vd8_log(vdouble8 a) { vdouble8 r = { _ZGVeN8v_log(a.v) }; return r; }
+static inline vdouble8 vd8_exp(vdouble8 a) { vdouble8 r = { _ZGVeN8v_exp(a.v) }; return r; }
+#endif
+
+#elif defined(__AVX__)
+
+static inline vdouble8 vd8_load(const double *p) {
+    vdouble8 r = { _mm256_loadu_pd(p), _mm256_loadu_pd(p + 4) };
+    return r;
+}
+static inline void vd8_store(double *p, vdouble8 a) {
+    _mm256_storeu_pd(p, a.lo);
+    _mm256_storeu_pd(p + 4, a.hi);
+}
+static inline vdouble8 vd8_set1(double x) { vdouble8 r = { _mm256_set1_pd(x), _mm256_set1_pd(x) }; return r; }
+
+#define VEC_AVX_BINARY(name, intrinsic) \
+    static inline vdouble8 name(vdouble8 a, vdouble8 b) { \
+        vdouble8 r = { intrinsic(a.lo, b.lo), intrinsic(a.hi, b.hi) }; \
+        return r; \
+    }
+VEC_AVX_BINARY(vd8_add, _mm256_add_pd)
+VEC_AVX_BINARY(vd8_sub, _mm256_sub_pd)
+VEC_AVX_BINARY(vd8_mul, _mm256_mul_pd)
+VEC_AVX_BINARY(vd8_div, _mm256_div_pd)
+#undef VEC_AVX_BINARY
+
+static inline vdouble8 vd8_sqrt(vdouble8 a) { vdouble8 r = { _mm256_sqrt_pd(a.lo), _mm256_sqrt_pd(a.hi) }; return r; }
+
+static inline vdouble8 vd8_fabs(vdouble8 a) {
+    __m256d sign = _mm256_set1_pd(-0.0);
+    vdouble8 r = { _mm256_andnot_pd(sign, a.lo), _mm256_andnot_pd(sign, a.hi) };
+    return r;
+}
+
+static inline vdouble8 vd8_neg(vdouble8 a) {
+    __m256d sign = _mm256_set1_pd(-0.0);
+    vdouble8 r = { _mm256_xor_pd(a.lo, sign), _mm256_xor_pd(a.hi, sign) };
+    return r;
+}
+
+static inline double vd8_reduce_add(vdouble8 a) {
+    __m256d s = _mm256_add_pd(a.lo, a.hi);
+    __m128d t = _mm_add_pd(_mm256_castpd256_pd128(s), _mm256_extractf128_pd(s, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(t, _mm_unpackhi_pd(t, t)));
+}
+
+#ifdef VEC_VECTOR_MATH
+static inline vdouble8 vd8_log(vdouble8 a) { vdouble8 r = { _ZGVdN4v_log(a.lo), _ZGVdN4v_log(a.hi) }; return r; }
+static inline vdouble8 vd8_exp(vdouble8 a) { vdouble8 r = { _ZGVdN4v_exp(a.lo), _ZGVdN4v_exp(a.hi) }; return r; }
+#endif
+
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+
+static inline vdouble8 vd8_load(const double *p) {
+    vdouble8 r = {{ vld1q_f64(p), vld1q_f64(p + 2), vld1q_f64(p + 4), vld1q_f64(p + 6) }};
+    return r;
+}
+static inline void vd8_store(double *p, vdouble8 a) {
+    for (int k = 0; k < 4; k++) vst1q_f64(p + 2 * k, a.v[k]);
+}
+static inline vdouble8 vd8_set1(double x) {
+    float64x2_t s = vdupq_n_f64(x);
+    vdouble8 r = {{ s, s, s, s }};
+    return r;
+}
+
+#define VEC_NEON_BINARY(name, intrinsic) \
+    static inline vdouble8 name(vdouble8 a, vdouble8 b) { \
+        vdouble8 r; \
+        for (int k = 0; k < 4; k++) r.v[k] = intrinsic(a.v[k], b.v[k]); \
+        return r; \
+    }
+#define VEC_NEON_UNARY(name, intrinsic) \
+    static inline vdouble8 name(vdouble8 a) { \
+        vdouble8 r; \
+        for (int k = 0; k < 4; k++) r.v[k] = intrinsic(a.v[k]); \
+        return r; \
+    }
+VEC_NEON_BINARY(vd8_add, vaddq_f64)
+VEC_NEON_BINARY(vd8_sub, vsubq_f64)
+VEC_NEON_BINARY(vd8_mul, vmulq_f64)
+VEC_NEON_BINARY(vd8_div, vdivq_f64)
+VEC_NEON_UNARY(vd8_sqrt, vsqrtq_f64)
+VEC_NEON_UNARY(vd8_fabs, vabsq_f64)
+VEC_NEON_UNARY(vd8_neg, vnegq_f64)
+#undef VEC_NEON_BINARY
+#undef VEC_NEON_UNARY
+
+static inline double vd8_reduce_add(vdouble8 a) {
+    float64x2_t t = vaddq_f64(vaddq_f64(a.v[0], a.v[2]), vaddq_f64(a.v[1], a.v[3]));
+    return vgetq_lane_f64(t, 0) + vgetq_lane_f64(t, 1);
+}
+
+#else
+
+static inline vdouble8 vd8_load(const double *p) {
+    vdouble8 r;
+    for (int k = 0; k < VEC_WIDTH; k++) r.v[k] = p[k];
+    return r;
+}
+static inline void vd8_store(double *p, vdouble8 a) {
+    for (int k = 0; k < VEC_WIDTH; k++) p[k] = a.v[k];
+}
+static inline vdouble8 vd8_set1(double x) {
+    vdouble8 r;
+    for (int k = 0; k < VEC_WIDTH; k++) r.v[k] = x;
+    return r;
+}
+
+#define VEC_SCALAR_BINARY(name, op) \
+    static inline vdouble8 name(vdouble8 a, vdouble8 b) { \
+        vdouble8 r; \
+        for (int k = 0; k < VEC_WIDTH; k++) r.v[k] = a.v[k] op b.v[k]; \
+        return r; \
+    }
+#define VEC_SCALAR_UNARY(name, expr) \
+    static inline vdouble8 name(vdouble8 a) { \
+        vdouble8 r; \
+        for (int k = 0; k < VEC_WIDTH; k++) r.v[k] = expr; \
+        return r; \
+    }
+VEC_SCALAR_BINARY(vd8_add, +)
+VEC_SCALAR_BINARY(vd8_sub, -)
+VEC_SCALAR_BINARY(vd8_mul, *)
+VEC_SCALAR_BINARY(vd8_div, /)
+VEC_SCALAR_UNARY(vd8_sqrt, sqrt(a.v[k]))
+VEC_SCALAR_UNARY(vd8_fabs, fabs(a.v[k]))
+VEC_SCALAR_UNARY(vd8_neg, -a.v[k])
+#undef VEC_SCALAR_BINARY
+#undef VEC_SCALAR_UNARY
+
+static inline double vd8_reduce_add(vdouble8 a) {
+    double t0 = (a.v[0] + a.v[4]) + (a.v[2] + a.v[6]);
+    double t1 = (a.v[1] + a.v[5]) + (a.v[3] + a.v[7]);
+    return t0 + t1;
+}
+
+#endif
+
+#ifndef VEC_VECTOR_MATH
+static inline vdouble8 vd8_map(vdouble8 a, double (*f)(double)) {
+    double lanes[VEC_WIDTH];
+    vd8_store(lanes, a);
+    for (int k = 0; k < VEC_WIDTH; k++) lanes[k] = f(lanes[k]);
+    return vd8_load(lanes);
+}
+
+static inline vdouble8 vd8_log(vdouble8 a) { return vd8_map(a, log); }
+static inline vdouble8 vd8_exp(vdouble8 a) { return vd8_map(a, exp); }
+#endif
+
+#endif
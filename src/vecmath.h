@@ -0,0 +1,34 @@
+#ifndef VECMATH_H
+#define VECMATH_H
+
+/*
+ * Vector math backend for transcendental calls inside omp simd loops.
+ *
+ * Without a backend, log()/exp() in a "#pragma omp simd" loop stay scalar
+ * libm calls unless -ffast-math is given. Declaring them "omp declare simd"
+ * lets the compiler call vector-ABI variants (_ZGVdN4v_log etc.), which both
+ * glibc libmvec and SLEEF's GNU-ABI library provide:
+ *
+ *   -DVECMATH_LIBMVEC   link with -lmvec -lm
+ *   -DVECMATH_SLEEF     link with -lsleefgnuabi -lm
+ *
+ * SVML needs no declarations; it is selected by the compiler instead
+ * (icx -fimf-use-svml, or GCC -mveclibabi=svml -ffast-math).
+ */
+
+#include <math.h>
+
+#if defined(VECMATH_LIBMVEC) || defined(VECMATH_SLEEF)
+#pragma omp declare simd notinbranch
+double log(double);
+#pragma omp declare simd notinbranch
+double exp(double);
+#pragma omp declare simd notinbranch
+double pow(double, double);
+#pragma omp declare simd notinbranch
+double sin(double);
+#pragma omp declare simd notinbranch
+double cos(double);
+#endif
+
+#endif